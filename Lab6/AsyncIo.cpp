@@ -0,0 +1,651 @@
+#include "AsyncIo.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LAB6_ASYNC_IO
+#endif
+#endif
+
+#ifdef LAB6_ASYNC_IO
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct AsyncSlot
+{
+	char* buffer;
+	size_t length;
+	long long offset;
+	long long sequence;
+	bool pending;
+	bool done;
+	long result;
+};
+
+// Два блока файла в полете: чтение на блок вперед или запись предыдущего блока.
+// Слот отдается ядру (io_uring) или фоновому потоку (pread/pwrite) и ждется перед повторным использованием.
+class AsyncBlockFile
+{
+public:
+	AsyncBlockFile(FILE* file, bool write);
+	~AsyncBlockFile();
+
+	bool Start(AsyncIoBackend backend);
+	ssize_t Read(char* buffer, size_t size);
+	ssize_t Write(const char* buffer, size_t size);
+	int Close();
+
+private:
+	bool SetupRing();
+	void Submit(int index);
+	long Wait(int index);
+	long ReadRest(AsyncSlot* slot, long read);
+	long WriteRest(AsyncSlot* slot, long written);
+	void SubmitRing(AsyncSlot* slot, int index);
+	void ReapRing(AsyncSlot* slot);
+	static void WorkerLoop(AsyncBlockFile* file);
+
+	FILE* _file;
+	int _fd;
+	bool _write;
+	bool _seekable;
+	bool _failed;
+	long long _offset;
+	long long _sequence;
+	AsyncSlot _slots[2];
+	int _current;
+	size_t _position;
+	AsyncIoBackend _backend;
+
+	int _ringFd;
+	void* _sqRing;
+	size_t _sqRingLength;
+	void* _cqRing;
+	size_t _cqRingLength;
+	io_uring_sqe* _sqes;
+	size_t _sqesLength;
+	unsigned* _sqTail;
+	unsigned* _sqMask;
+	unsigned* _sqArray;
+	unsigned* _cqHead;
+	unsigned* _cqTail;
+	unsigned* _cqMask;
+	io_uring_cqe* _cqes;
+
+	std::thread _worker;
+	std::mutex _mutex;
+	std::condition_variable _submitted;
+	std::condition_variable _completed;
+	bool _stopped;
+};
+
+AsyncBlockFile::AsyncBlockFile(FILE* file, bool write)
+{
+	_file = file;
+	_fd = fileno(file);
+	_write = write;
+	_failed = false;
+	_sequence = 0;
+	_current = 0;
+	_position = 0;
+	_backend = ASYNC_IO_THREAD;
+	_ringFd = -1;
+	_sqRing = MAP_FAILED;
+	_cqRing = MAP_FAILED;
+	_sqes = (io_uring_sqe*)MAP_FAILED;
+	_stopped = false;
+
+	//Стандартный поток мог уже что-то накопить в своем буфере - дописываем до того, как писать мимо него
+	if (write)
+	{
+		fflush(file);
+	}
+
+	_offset = write ? lseek(_fd, 0, SEEK_CUR) : ftell(file);
+	_seekable = _offset >= 0 && (!write || (fcntl(_fd, F_GETFL) & O_APPEND) == 0);
+
+	for (int i = 0; i < 2; i++)
+	{
+		_slots[i].buffer = new char[asyncBlockLength];
+		_slots[i].length = 0;
+		_slots[i].offset = 0;
+		_slots[i].sequence = 0;
+		_slots[i].pending = false;
+		_slots[i].done = false;
+		_slots[i].result = 0;
+	}
+}
+
+AsyncBlockFile::~AsyncBlockFile()
+{
+	//Буферы и кольца нельзя освобождать, пока ядро или поток с ними работают
+	for (int i = 0; i < 2; i++)
+	{
+		Wait(i);
+	}
+
+	if (_worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopped = true;
+		}
+		_submitted.notify_all();
+		_worker.join();
+	}
+
+	if (_sqes != MAP_FAILED)
+	{
+		munmap(_sqes, _sqesLength);
+	}
+
+	if (_cqRing != MAP_FAILED && _cqRing != _sqRing)
+	{
+		munmap(_cqRing, _cqRingLength);
+	}
+
+	if (_sqRing != MAP_FAILED)
+	{
+		munmap(_sqRing, _sqRingLength);
+	}
+
+	if (_ringFd >= 0)
+	{
+		close(_ringFd);
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		delete[] _slots[i].buffer;
+	}
+}
+
+//Кольца io_uring без liburing: io_uring_setup, отображение колец и массива запросов, io_uring_enter
+bool AsyncBlockFile::SetupRing()
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	_ringFd = (int)syscall(__NR_io_uring_setup, 4, &params);
+	if (_ringFd < 0)
+	{
+		return false;
+	}
+
+	//IORING_OP_READ/WRITE и смещение -1 для каналов появились вместе с этим признаком (5.6)
+	if ((params.features & IORING_FEAT_RW_CUR_POS) == 0)
+	{
+		return false;
+	}
+
+	_sqRingLength = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cqRingLength = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap && _cqRingLength > _sqRingLength)
+	{
+		_sqRingLength = _cqRingLength;
+	}
+
+	_sqRing = mmap(NULL, _sqRingLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+	if (_sqRing == MAP_FAILED)
+	{
+		return false;
+	}
+
+	_cqRing = singleMap ? _sqRing : mmap(NULL, _cqRingLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+	if (_cqRing == MAP_FAILED)
+	{
+		return false;
+	}
+
+	_sqesLength = params.sq_entries * sizeof(io_uring_sqe);
+	_sqes = (io_uring_sqe*)mmap(NULL, _sqesLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+	if (_sqes == MAP_FAILED)
+	{
+		return false;
+	}
+
+	char* sq = (char*)_sqRing;
+	char* cq = (char*)_cqRing;
+	_sqTail = (unsigned*)(sq + params.sq_off.tail);
+	_sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+	_sqArray = (unsigned*)(sq + params.sq_off.array);
+	_cqHead = (unsigned*)(cq + params.cq_off.head);
+	_cqTail = (unsigned*)(cq + params.cq_off.tail);
+	_cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+	_cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+	return true;
+}
+
+bool AsyncBlockFile::Start(AsyncIoBackend backend)
+{
+	if (!_write && !_seekable)
+	{
+		return false;
+	}
+
+	if (backend == ASYNC_IO_URING && SetupRing())
+	{
+		_backend = ASYNC_IO_URING;
+	}
+	else
+	{
+		_backend = ASYNC_IO_THREAD;
+		_worker = std::thread(WorkerLoop, this);
+	}
+
+	//Чтение сразу на два блока вперед
+	if (!_write)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			_slots[i].length = asyncBlockLength;
+			Submit(i);
+		}
+	}
+
+	return true;
+}
+
+void AsyncBlockFile::Submit(int index)
+{
+	//Без смещений (канал, O_APPEND) порядок записей держим сами: следующий блок уходит после предыдущего
+	if (_write && !_seekable)
+	{
+		Wait(index ^ 1);
+	}
+
+	AsyncSlot* slot = &_slots[index];
+	slot->offset = _seekable ? _offset : -1;
+	slot->sequence = _sequence++;
+	slot->done = false;
+	slot->result = 0;
+	if (_seekable)
+	{
+		_offset += slot->length;
+	}
+
+	if (_backend == ASYNC_IO_URING)
+	{
+		slot->pending = true;
+		SubmitRing(slot, index);
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			slot->pending = true;
+		}
+		_submitted.notify_one();
+	}
+}
+
+void AsyncBlockFile::SubmitRing(AsyncSlot* slot, int index)
+{
+	unsigned tail = *_sqTail;
+	unsigned position = tail & *_sqMask;
+	io_uring_sqe* sqe = &_sqes[position];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = _write ? IORING_OP_WRITE : IORING_OP_READ;
+	sqe->fd = _fd;
+	sqe->addr = (unsigned long long)(size_t)slot->buffer;
+	sqe->len = (unsigned)slot->length;
+	sqe->off = (unsigned long long)slot->offset;
+	sqe->user_data = (unsigned long long)index;
+	_sqArray[position] = position;
+	__atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+	int submitted;
+	do
+	{
+		submitted = (int)syscall(__NR_io_uring_enter, _ringFd, 1, 0, 0, NULL, 0);
+	}
+	while (submitted < 0 && errno == EINTR);
+
+	if (submitted < 0)
+	{
+		slot->result = -errno;
+		slot->done = true;
+	}
+}
+
+void AsyncBlockFile::ReapRing(AsyncSlot* slot)
+{
+	while (!slot->done)
+	{
+		unsigned head = *_cqHead;
+		unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++)
+		{
+			io_uring_cqe* cqe = &_cqes[head & *_cqMask];
+			AsyncSlot* completed = &_slots[cqe->user_data];
+			completed->result = cqe->res;
+			completed->done = true;
+		}
+		__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+		if (!slot->done && syscall(__NR_io_uring_enter, _ringFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+		{
+			slot->result = -errno;
+			slot->done = true;
+		}
+	}
+}
+
+//Запросы выполняются по одному в порядке подачи: у канала вывода нет смещений
+void AsyncBlockFile::WorkerLoop(AsyncBlockFile* file)
+{
+	std::unique_lock<std::mutex> lock(file->_mutex);
+	while (true)
+	{
+		AsyncSlot* slot = NULL;
+		for (int i = 0; i < 2; i++)
+		{
+			AsyncSlot* candidate = &file->_slots[i];
+			if (candidate->pending && !candidate->done && (slot == NULL || candidate->sequence < slot->sequence))
+			{
+				slot = candidate;
+			}
+		}
+
+		if (slot == NULL)
+		{
+			if (file->_stopped)
+			{
+				return;
+			}
+
+			file->_submitted.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+		ssize_t result;
+		do
+		{
+			if (file->_write)
+			{
+				result = slot->offset >= 0 ? pwrite(file->_fd, slot->buffer, slot->length, slot->offset) : write(file->_fd, slot->buffer, slot->length);
+			}
+			else
+			{
+				result = pread(file->_fd, slot->buffer, slot->length, slot->offset);
+			}
+		}
+		while (result < 0 && errno == EINTR);
+		long value = result >= 0 ? (long)result : -errno;
+		lock.lock();
+
+		slot->result = value;
+		slot->done = true;
+		file->_completed.notify_all();
+	}
+}
+
+//Дочитывает остаток блока после короткого чтения: конец файла - только чтение, вернувшее 0,
+//иначе следующий блок, уже поданный со смещения после этого, оставил бы в тексте дыру
+long AsyncBlockFile::ReadRest(AsyncSlot* slot, long read)
+{
+	while (read > 0 && (size_t)read < slot->length)
+	{
+		ssize_t result = pread(_fd, slot->buffer + read, slot->length - read, slot->offset + read);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (result < 0)
+		{
+			return -1;
+		}
+
+		if (result == 0)
+		{
+			break;
+		}
+
+		read += (long)result;
+	}
+
+	return read;
+}
+
+//Дописывает остаток блока после короткой записи
+long AsyncBlockFile::WriteRest(AsyncSlot* slot, long written)
+{
+	while (written >= 0 && (size_t)written < slot->length)
+	{
+		ssize_t result = slot->offset >= 0
+			? pwrite(_fd, slot->buffer + written, slot->length - written, slot->offset + written)
+			: write(_fd, slot->buffer + written, slot->length - written);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (result <= 0)
+		{
+			return -1;
+		}
+
+		written += (long)result;
+	}
+
+	return written;
+}
+
+long AsyncBlockFile::Wait(int index)
+{
+	AsyncSlot* slot = &_slots[index];
+	if (!slot->pending)
+	{
+		return (long)slot->length;
+	}
+
+	if (_backend == ASYNC_IO_URING)
+	{
+		ReapRing(slot);
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (!slot->done)
+		{
+			_completed.wait(lock);
+		}
+	}
+
+	slot->pending = false;
+	long result = slot->result;
+	if (result >= 0)
+	{
+		result = _write ? WriteRest(slot, result) : ReadRest(slot, result);
+	}
+
+	if (result < 0)
+	{
+		_failed = true;
+	}
+
+	return result;
+}
+
+ssize_t AsyncBlockFile::Read(char* buffer, size_t size)
+{
+	size_t copied = 0;
+	while (copied < size && !_failed)
+	{
+		AsyncSlot* slot = &_slots[_current];
+		if (slot->pending)
+		{
+			long result = Wait(_current);
+			slot->length = result > 0 ? (size_t)result : 0;
+			_position = 0;
+		}
+
+		if (_position == slot->length)
+		{
+			//Короткий блок (дочитанный до нуля) - конец файла; прочитанный целиком отдаем под блок через один
+			if (slot->length < (size_t)asyncBlockLength)
+			{
+				break;
+			}
+
+			slot->length = asyncBlockLength;
+			Submit(_current);
+			_current ^= 1;
+			continue;
+		}
+
+		size_t length = slot->length - _position;
+		if (length > size - copied)
+		{
+			length = size - copied;
+		}
+
+		memcpy(buffer + copied, slot->buffer + _position, length);
+		_position += length;
+		copied += length;
+	}
+
+	return copied == 0 && _failed ? -1 : (ssize_t)copied;
+}
+
+ssize_t AsyncBlockFile::Write(const char* buffer, size_t size)
+{
+	size_t copied = 0;
+	while (copied < size && !_failed)
+	{
+		AsyncSlot* slot = &_slots[_current];
+		size_t length = asyncBlockLength - _position;
+		if (length > size - copied)
+		{
+			length = size - copied;
+		}
+
+		memcpy(slot->buffer + _position, buffer + copied, length);
+		_position += length;
+		copied += length;
+
+		//Полный блок уходит на запись, а заполнять начинаем второй, дождавшись его прошлой записи
+		if (_position == (size_t)asyncBlockLength)
+		{
+			slot->length = _position;
+			Submit(_current);
+			_current ^= 1;
+			_position = 0;
+			Wait(_current);
+		}
+	}
+
+	//fopencookie: ошибка записи - 0, а не -1
+	return _failed ? 0 : (ssize_t)copied;
+}
+
+int AsyncBlockFile::Close()
+{
+	if (_write && _position > 0 && !_failed)
+	{
+		_slots[_current].length = _position;
+		Submit(_current);
+		_position = 0;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		Wait(i);
+	}
+
+	//pwrite не сдвигает позицию файла - ставим ее за выведенным
+	if (_write && _seekable)
+	{
+		lseek(_fd, _offset, SEEK_SET);
+	}
+
+	int result = _failed ? EOF : 0;
+	if (_file == stdin || _file == stdout || _file == stderr)
+	{
+		return result;
+	}
+
+	return fclose(_file) == 0 ? result : EOF;
+}
+
+static ssize_t ReadAsyncCookie(void* cookie, char* buffer, size_t size)
+{
+	return ((AsyncBlockFile*)cookie)->Read(buffer, size);
+}
+
+static ssize_t WriteAsyncCookie(void* cookie, const char* buffer, size_t size)
+{
+	return ((AsyncBlockFile*)cookie)->Write(buffer, size);
+}
+
+static int CloseAsyncCookie(void* cookie)
+{
+	AsyncBlockFile* file = (AsyncBlockFile*)cookie;
+	int result = file->Close();
+	delete file;
+	return result;
+}
+
+static FILE* OpenAsyncFile(FILE* file, bool write, AsyncIoBackend backend)
+{
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	AsyncBlockFile* asyncFile = new AsyncBlockFile(file, write);
+	if (!asyncFile->Start(backend))
+	{
+		delete asyncFile;
+		return file;
+	}
+
+	cookie_io_functions_t functions;
+	memset(&functions, 0, sizeof(functions));
+	functions.read = write ? NULL : ReadAsyncCookie;
+	functions.write = write ? WriteAsyncCookie : NULL;
+	functions.close = CloseAsyncCookie;
+
+	FILE* result = fopencookie(asyncFile, write ? "w" : "r", functions);
+	if (result == NULL)
+	{
+		delete asyncFile;
+		return file;
+	}
+
+	return result;
+}
+
+FILE* OpenAsyncInput(FILE* file, AsyncIoBackend backend)
+{
+	return OpenAsyncFile(file, false, backend);
+}
+
+FILE* OpenAsyncOutput(FILE* file, AsyncIoBackend backend)
+{
+	return OpenAsyncFile(file, true, backend);
+}
+
+#else
+
+FILE* OpenAsyncInput(FILE* file, AsyncIoBackend backend)
+{
+	return file;
+}
+
+FILE* OpenAsyncOutput(FILE* file, AsyncIoBackend backend)
+{
+	return file;
+}
+
+#endif
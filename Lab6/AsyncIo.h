@@ -0,0 +1,19 @@
+#ifndef H_ASYNC_IO
+#define H_ASYNC_IO
+
+#include <stdio.h>
+
+enum AsyncIoBackend {ASYNC_IO_URING, ASYNC_IO_THREAD};
+
+// Чтение задания с упреждением и запись вывода в фоне (Linux). Файл идет блоками по asyncBlockLength
+// в двух буферах: пока разбирается один блок, следующий уже читается; пока заполняется один блок вывода,
+// предыдущий пишется. Блоки отдаются ядру через io_uring, а если его нет (старое ядро, запрет в контейнере) -
+// фоновому потоку с pread/pwrite.
+// Возвращается FILE* поверх исходного (fopencookie); его закрытие дописывает вывод и закрывает исходный
+// файл (стандартные потоки не закрываются). Если обернуть нельзя (не Linux, вход - канал), возвращается сам file.
+static const int asyncBlockLength = 1 << 20;
+
+FILE* OpenAsyncInput(FILE* file, AsyncIoBackend backend);
+FILE* OpenAsyncOutput(FILE* file, AsyncIoBackend backend);
+
+#endif
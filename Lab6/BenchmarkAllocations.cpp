@@ -0,0 +1,27 @@
+#include "BenchmarkAllocations.h"
+#include <new>
+#include <stdlib.h>
+
+long long allocationsCount = 0;
+
+void* operator new(size_t size)
+{
+	allocationsCount++;
+	void* memory = malloc(size);
+	if (memory == NULL)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
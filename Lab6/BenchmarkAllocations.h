@@ -0,0 +1,8 @@
+#ifndef H_BENCHMARK_ALLOCATIONS
+#define H_BENCHMARK_ALLOCATIONS
+
+// Вызовы глобального operator new в бенчмарках. Замена operator new/delete лежит в своей единице трансляции:
+// иначе компилятор встраивает free в delete рядом с new и предупреждает о несовпадении (-Wmismatched-new-delete).
+extern long long allocationsCount;
+
+#endif
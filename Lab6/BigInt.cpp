@@ -1,4 +1,22 @@
 #include "BigInt.h"
+#include "PreparedDivisor.h"
+#include "PowerCache.h"
+#include "Instrumentation.h"
+#include "LimbKernels.h"
+#include "LimbMemory.h"
+#include <string.h>
+#include <math.h>
+
+void* BigInt::operator new(size_t size)
+{
+	INSTRUMENT_ALLOCATION();
+	return AllocateLimbs(size);
+}
+
+void BigInt::operator delete(void* memory)
+{
+	FreeLimbs(memory);
+}
 
 BigInt::BigInt()
 {
@@ -10,15 +28,37 @@ BigInt::BigInt()
 	size = 0;
 }
 
-BigInt::BigInt(int digit)
+//Раскладываем число по "цифрам", если оно не меньше основания
+static int SplitDigit(int digit, int* digits)
 {
-	digits[0] = digit;
-	for(int i = 1; i < BigInt::maxDigitsCount; i++)
+	int size = 0;
+	do
 	{
-		digits[i] = 0;
+		digits[size] = digit % BigInt::base;
+		digit /= BigInt::base;
+		size++;
 	}
+	while (digit > 0);
 
-	size = 1;
+	return size;
+}
+
+BigInt::BigInt(int digit)
+{
+	size = SplitDigit(digit, digits);
+}
+
+//Под результат операции: нули только в первых limbsCount "цифрах" - столько, сколько операция может занять
+BigInt::BigInt(int digit, int limbsCount)
+{
+	memset(digits, 0, Min(limbsCount, BigInt::maxDigitsCount) * sizeof(int));
+	size = SplitDigit(digit, digits);
+}
+
+BigInt::BigInt(const BigInt& digit)
+{
+	size = digit.size;
+	memcpy(digits, digit.digits, size * sizeof(int));
 }
 
 bool IsZero(const BigInt* digit)
@@ -26,36 +66,61 @@ bool IsZero(const BigInt* digit)
 	return digit->size == 1 && digit->digits[0] == 0;
 }
 
+//Общая часть складывается сразу по многу "цифр", остаток длинного операнда только пропускает перенос
+static int AddDigits(int* result, const BigInt* left, const BigInt* right)
+{
+	const BigInt* longer = left->size >= right->size ? left : right;
+	int common = Min(left->size, right->size);
+	int carry = AddLimbs(result, left->digits, right->digits, common);
+
+	return PropagateCarry(result + common, longer->digits + common, longer->size - common, carry);
+}
+
 BigInt* Add(const BigInt* left, const BigInt* right)
 {
-	BigInt* result = new BigInt();
+	INSTRUMENT_KERNEL(KERNEL_ADD, Max(left->size, right->size));
 	int maxAmount = Max(left->size, right->size);
-	int carry = 0;
+	BigInt* result = new BigInt(0, maxAmount + 1);
 
-	for (int i = 0; i < maxAmount + carry; i++)
+	//Если сумма длиннее слагаемых, появляется старшая "цифра" из переноса
+	if (AddDigits(result->digits, left, right) != 0)
 	{
-		int sum = left->digits[i] + right->digits[i] + carry;
-
-		//     ,  
-		if (sum >= BigInt::base)
+		if (maxAmount == BigInt::maxDigitsCount)
 		{
-			result->digits[i] = sum - BigInt::base;
-			carry = 1;
+			delete result;
+			throw AppException(ErrorMessages::ERROR);
 		}
-		else
+
+		result->digits[maxAmount] = 1;
+		maxAmount++;
+	}
+
+	result->size = maxAmount;
+	return result;
+}
+
+void AddTo(BigInt* left, const BigInt* right)
+{
+	INSTRUMENT_KERNEL(KERNEL_ADD, Max(left->size, right->size));
+	int maxAmount = Max(left->size, right->size);
+
+	if (AddDigits(left->digits, left, right) != 0)
+	{
+		if (maxAmount == BigInt::maxDigitsCount)
 		{
-			result->digits[i] = sum;
-			carry = 0;
+			throw AppException(ErrorMessages::ERROR);
 		}
-	}
 
-	result->size = result->digits[maxAmount] != 0 ? maxAmount + 1 : maxAmount;
+		left->digits[maxAmount] = 1;
+		maxAmount++;
+	}
 
-	return result;
+	left->size = maxAmount;
 }
 
 bool AreEquals(const BigInt* left, const BigInt* right)
 {
+	INSTRUMENT_KERNEL(KERNEL_COMPARE, left->size);
 	if (left->size != right->size)
 	{
 		return false;
@@ -74,12 +139,13 @@ bool AreEquals(const BigInt* left, const BigInt* right)
 
 bool IsGreater(const BigInt* left, const BigInt* right)
 {
+	INSTRUMENT_KERNEL(KERNEL_COMPARE, left->size);
 	if (left->size != right->size)
 	{
 		return left->size > right->size;
 	}
 
-	for(int i = left->size; i >= 0; i--)
+	for(int i = left->size - 1; i >= 0; i--)
 	{
 		if (left->digits[i] != right->digits[i])
 		{
@@ -92,12 +158,13 @@ bool IsGreater(const BigInt* left, const BigInt* right)
 
 bool IsLess(const BigInt* left, const BigInt* right)
 {
+	INSTRUMENT_KERNEL(KERNEL_COMPARE, left->size);
 	if (left->size != right->size)
 	{
 		return left->size < right->size;
 	}
 
-	for(int i = left->size; i >= 0; i--)
+	for(int i = left->size - 1; i >= 0; i--)
 	{
 		if (left->digits[i] != right->digits[i])
 		{
@@ -110,84 +177,97 @@ bool IsLess(const BigInt* left, const BigInt* right)
 
 BigInt* Subtract(const BigInt* left, const BigInt* right)
 {
+	INSTRUMENT_KERNEL(KERNEL_SUBTRACT, left->size);
 	if (IsLess(left, right))
 	{
 		throw AppException(ErrorMessages::ERROR);
 	}
 
-	BigInt* result = new BigInt();
-	int carry = 0;
-	for(int i = 0; i < left->size; i++)
-	{
-		int subtraction = left->digits[i] - right->digits[i] - carry;
-		if (subtraction >= 0)
-		{
-			result->digits[i] = subtraction;
-			carry = 0;
-		}
-		else
-		{
-			result->digits[i] = BigInt::base + subtraction;
-			carry = 1;
-		}
-	}
+	BigInt* result = new BigInt(0, left->size);
+	int borrow = SubtractLimbs(result->digits, left->digits, right->digits, right->size);
+	PropagateBorrow(result->digits + right->size, left->digits + right->size, left->size - right->size, borrow);
 
 	result->size = DeleteExtraZeros(left->size, result);
 	return result;
 }
 
-BigInt* Multiply(const BigInt* left, const BigInt* right)
+void SubtractFrom(BigInt* left, const BigInt* right)
 {
-	if (left->size + right->size > BigInt::maxDigitsCount)
+	INSTRUMENT_KERNEL(KERNEL_SUBTRACT, left->size);
+	if (IsLess(left, right))
 	{
 		throw AppException(ErrorMessages::ERROR);
 	}
 
-	if (IsZero(left) || IsZero(right))
-	{
-		return new BigInt(0);
-	}
+	int borrow = SubtractLimbs(left->digits, left->digits, right->digits, right->size);
+	PropagateBorrow(left->digits + right->size, left->digits + right->size, left->size - right->size, borrow);
 
-	BigInt* result = new BigInt();
+	left->size = DeleteExtraZeros(left->size, left);
+}
+
+//Произведение в уже выделенное число; размеры проверяет вызывающий
+static void MultiplyInto(const BigInt* left, const BigInt* right, BigInt* result)
+{
+	//Первое прибавление идет к нулям, дальше ячейки заполняются по ходу
+	memset(result->digits, 0, left->size * sizeof(int));
 
-	//    ""  
+	//Идем последовательно по каждой "цифре" второго числа
 	for (int i = 0; i < right->size; i++)
 	{
-		int carry = 0;
-		//   ""     
-		for (int j = 0; j < left->size || carry > 0; j++)
-		{
-			//     +   +    
-			int mult = result->digits[i+j] + left->digits[j] * right->digits[i] + carry;
-			carry = mult / BigInt::base;
-			//   
-			result->digits[i+j] = mult - carry*BigInt::base;
-		}
+		//Прибавляем первое число, умноженное на "цифру", со сдвигом; старше переноса ячейка еще пустая
+		result->digits[i + left->size] = MultiplyAddLimbs(result->digits + i, left->digits, left->size, right->digits[i]);
 	}
 
-	//   
+	//Вычисляем размер получившегося числа
 	result->size = DeleteExtraZeros(left->size + right->size, result);
+}
+
+BigInt* Multiply(const BigInt* left, const BigInt* right)
+{
+	INSTRUMENT_KERNEL(KERNEL_MULTIPLY, (long long)left->size * right->size);
+	if (left->size + right->size > BigInt::maxDigitsCount)
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	if (IsZero(left) || IsZero(right))
+	{
+		return new BigInt(0);
+	}
+
+	BigInt* result = new BigInt(0, left->size + right->size);
+	MultiplyInto(left, right, result);
 
 	return result;
 }
 
 BigInt* Multiply(const BigInt* left, int right)
 {
-	BigInt* result = new BigInt();
-
-	int carry = 0;
-	//    ""     
-	for (int i = 0; i < left->size || carry > 0; i++)
+	INSTRUMENT_KERNEL(KERNEL_MULTIPLY_SHORT, left->size);
+	//Перенос меньше 2^31 занимает не больше трех "цифр"
+	BigInt* result = new BigInt(0, left->size + 3);
+
+	//Множители до base (все вызовы из деления и НОД) умножаются без деления
+	int carry = right >= 0 && right <= BigInt::base
+		? MultiplyLimbs(result->digits, left->digits, left->size, right)
+		: MultiplyLimbsByDivision(result->digits, left->digits, left->size, right);
+
+	//Перенос от большого множителя может занять несколько "цифр"
+	int size = left->size;
+	for (; carry > 0; size++)
 	{
-		//     +   +    
-		int mult = left->digits[i] * right + carry;
-		carry = mult / BigInt::base;
-		//   
-		result->digits[i] = mult - carry*BigInt::base;
+		if (size == BigInt::maxDigitsCount)
+		{
+			delete result;
+			throw AppException(ErrorMessages::ERROR);
+		}
+
+		result->digits[size] = carry % BigInt::base;
+		carry /= BigInt::base;
 	}
 
-	//   
-	result->size = DeleteExtraZeros(left->size + 1, result);
+	//Вычисляем размер получившегося числа
+	result->size = DeleteExtraZeros(size, result);
 	return result;
 }
 
@@ -226,40 +306,44 @@ int FindDivisor(BigInt** divident, const BigInt* divisor)
 	return half;
 }
 
-void DeleteExtraZeros( BigInt* divident, BigInt* result );
-
 BigInt* Divide(const BigInt* left, const BigInt* right)
 {
-	if (IsZero(right))
+	PreparedDivisor divisor(right);
+	return divisor.Divide(left);
+}
+
+BigInt* Divide(const BigInt* left, int right)
+{
+	INSTRUMENT_KERNEL(KERNEL_DIVIDE_SHORT, left->size);
+	if (right == 0)
 	{
 		throw AppException(ErrorMessages::ERROR);
 	}
 
-	BigInt* result = new BigInt();
-	BigInt* divident = new BigInt();
-	//   
+	BigInt* result = new BigInt(0, left->size);
+	long long remainder = 0;
+	//Делим начиная со старшей "цифры", перенося остаток в следующую
 	for (int i = left->size - 1; i >= 0; i--)
 	{
-		//   ,  
-		for(int j = divident->size; j > 0; j--)
-		{
-			divident->digits[j] = divident->digits[j-1];
-		}
-		//  ""  
-		divident->digits[0] = left->digits[i];
-		divident->size++;
-		divident->size = DeleteExtraZeros(divident->size, divident);
-
-		result->digits[i] = FindDivisor(&divident, right);
+		long long current = remainder * BigInt::base + left->digits[i];
+		result->digits[i] = (int)(current / right);
+		remainder = current - (long long)result->digits[i] * right;
 	}
 
-	//    
 	result->size = DeleteExtraZeros(left->size, result);
 	return result;
 }
 
+//Нижняя оценка числа "цифр" left^exponent: left не меньше старшей "цифры", сдвинутой на size - 1 "цифр"
+double CountPowerLimbsLowerBound(const BigInt* left, int exponent)
+{
+	double limbs = (left->size - 1) + log10((double)left->digits[left->size - 1]) / BigInt::baseDimentions;
+	return limbs * exponent;
+}
+
 BigInt* Power(const BigInt* left, const BigInt* power)
 {
+	INSTRUMENT_KERNEL(KERNEL_POWER, left->size);
 	if (IsZero(power))
 	{
 		if (IsZero(left))
@@ -270,43 +354,290 @@ BigInt* Power(const BigInt* left, const BigInt* power)
 		return new BigInt(1);
 	}
 
-	BigInt* result = new BigInt(1);
+	//0 и 1 в любой степени не меняются
+	if (IsZero(left) || (left->size == 1 && left->digits[0] == 1))
+	{
+		return new BigInt(*left);
+	}
+
+	//Основание не меньше двух: если степень заведомо длиннее maxDigitsCount, умножать незачем
+	if (power->size > 2)
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
 
-	BigInt* n = new BigInt(*power);
+	int exponent = power->digits[0] + (power->size > 1 ? power->digits[1] * BigInt::base : 0);
+	if (CountPowerLimbsLowerBound(left, exponent) > BigInt::maxDigitsCount + 1)
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	//Все умножения идут в три числа, выделенные заранее: результат, квадрат и запасное под произведение
+	BigInt* result = new BigInt(1);
 	BigInt* digit = new BigInt(*left);
-	BigInt* two = new BigInt(2);
+	BigInt* spare = new BigInt(0);
+	bool overflow = false;
 
 	while (true)
 	{
-		//  ,    .
-		if (n->digits[0] & 1)
+		//Если показатель нечетный, то умножаем на число.
+		if (exponent & 1)
 		{
-			BigInt* oldResult = result;
-			result = Multiply(result, digit);
-			delete oldResult;
+			if (result->size + digit->size > BigInt::maxDigitsCount)
+			{
+				overflow = true;
+				break;
+			}
+
+			MultiplyInto(result, digit, spare);
+			BigInt* swap = result;
+			result = spare;
+			spare = swap;
 		}
 
-		BigInt* oldN = n;
-		n = Divide(n, two);
-		delete oldN;
+		exponent >>= 1;
+		if (exponent == 0)
+		{
+			break;
+		}
 
-		if (IsZero(n))
+		if (digit->size * 2 > BigInt::maxDigitsCount)
 		{
+			overflow = true;
 			break;
 		}
 
-		BigInt* oldDigit = digit;
-		digit = Multiply(digit, digit);
-		delete oldDigit;
+		MultiplyInto(digit, digit, spare);
+		BigInt* swap = digit;
+		digit = spare;
+		spare = swap;
 	}
 
-	delete two;
-	delete n;
 	delete digit;
+	delete spare;
+	if (overflow)
+	{
+		delete result;
+		throw AppException(ErrorMessages::ERROR);
+	}
 
 	return result;
 }
 
+BigInt* Power(const BigInt* left, const BigInt* power, PowerCache* cache)
+{
+	if (cache == NULL)
+	{
+		return Power(left, power);
+	}
+
+	return cache->Power(left, power);
+}
+
+static int CountDecDigits(const BigInt* digit)
+{
+	int count = (digit->size - 1) * BigInt::baseDimentions;
+	for (int top = digit->digits[digit->size - 1]; top > 0; top /= 10)
+	{
+		count++;
+	}
+
+	return count;
+}
+
+//Оценка сверху числа бит: log2(10) < 3.33
+static int CountBitsUpperBound(const BigInt* digit)
+{
+	return (CountDecDigits(digit) * 333 + 99) / 100;
+}
+
+//Начальное приближение корня сверху: 2^ceil(bits/degree)
+static BigInt* EstimateRoot(const BigInt* digit, int degree)
+{
+	int bits = CountBitsUpperBound(digit);
+	BigInt two(2);
+	BigInt exponent((bits + degree - 1) / degree);
+
+	return Power(&two, &exponent);
+}
+
+BigInt* SquareRoot(const BigInt* digit)
+{
+	INSTRUMENT_KERNEL(KERNEL_SQUARE_ROOT, digit->size);
+	if (IsZero(digit))
+	{
+		return new BigInt(0);
+	}
+
+	//Итерации Ньютона x = (x + a/x) / 2, пока приближение убывает
+	BigInt* x = EstimateRoot(digit, 2);
+	while (true)
+	{
+		BigInt* quotient = Divide(digit, x);
+		BigInt* sum = Add(x, quotient);
+		BigInt* next = Divide(sum, 2);
+		delete quotient;
+		delete sum;
+
+		if (!IsLess(next, x))
+		{
+			delete next;
+			break;
+		}
+
+		delete x;
+		x = next;
+	}
+
+	return x;
+}
+
+BigInt* Root(const BigInt* digit, const BigInt* degree)
+{
+	INSTRUMENT_KERNEL(KERNEL_ROOT, digit->size);
+	if (IsZero(degree))
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	if (IsZero(digit))
+	{
+		return new BigInt(0);
+	}
+
+	//Если 2^degree больше числа, корень равен единице
+	int bits = CountBitsUpperBound(digit);
+	int n = degree->size > 2 ? bits : degree->digits[0] + (degree->size > 1 ? degree->digits[1] * BigInt::base : 0);
+	if (n >= bits)
+	{
+		return new BigInt(1);
+	}
+
+	if (n == 1)
+	{
+		return new BigInt(*digit);
+	}
+
+	BigInt nMinusOne(n - 1);
+
+	//Итерации Ньютона x = ((n-1)x + a/x^(n-1)) / n, пока приближение убывает
+	BigInt* x = EstimateRoot(digit, n);
+	while (true)
+	{
+		BigInt* power = Power(x, &nMinusOne);
+		BigInt* quotient = Divide(digit, power);
+		BigInt* mult = Multiply(x, &nMinusOne);
+		BigInt* sum = Add(mult, quotient);
+		BigInt* next = Divide(sum, n);
+		delete power;
+		delete quotient;
+		delete mult;
+		delete sum;
+
+		if (!IsLess(next, x))
+		{
+			delete next;
+			break;
+		}
+
+		delete x;
+		x = next;
+	}
+
+	return x;
+}
+
+//Количество множителей 2, которые можно вынести за один сдвиг (основание делится только на 2^4)
+static int CountTrailingTwos(const BigInt* digit)
+{
+	int count = 0;
+	int lowest = digit->digits[0];
+	while (count < 4 && (lowest & 1) == 0)
+	{
+		lowest >>= 1;
+		count++;
+	}
+
+	return count;
+}
+
+static void ShiftRightInPlace(BigInt* digit, int count)
+{
+	int remainder = 0;
+	for (int i = digit->size - 1; i >= 0; i--)
+	{
+		int current = remainder * BigInt::base + digit->digits[i];
+		digit->digits[i] = current >> count;
+		remainder = current & ((1 << count) - 1);
+	}
+
+	digit->size = DeleteExtraZeros(digit->size, digit);
+}
+
+BigInt* Gcd(const BigInt* left, const BigInt* right)
+{
+	INSTRUMENT_KERNEL(KERNEL_GCD, Max(left->size, right->size));
+	if (IsZero(left))
+	{
+		return new BigInt(*right);
+	}
+
+	if (IsZero(right))
+	{
+		return new BigInt(*left);
+	}
+
+	BigInt* a = new BigInt(*left);
+	BigInt* b = new BigInt(*right);
+
+	//Выносим общую степень двойки
+	int shift = 0;
+	while (((a->digits[0] | b->digits[0]) & 1) == 0)
+	{
+		int count = Min(CountTrailingTwos(a), CountTrailingTwos(b));
+		ShiftRightInPlace(a, count);
+		ShiftRightInPlace(b, count);
+		shift += count;
+	}
+
+	while ((a->digits[0] & 1) == 0)
+	{
+		ShiftRightInPlace(a, CountTrailingTwos(a));
+	}
+
+	//Бинарный алгоритм: оба числа нечетные, из большего вычитаем меньшее
+	do
+	{
+		while ((b->digits[0] & 1) == 0)
+		{
+			ShiftRightInPlace(b, CountTrailingTwos(b));
+		}
+
+		if (IsGreater(a, b))
+		{
+			BigInt* swap = a;
+			a = b;
+			b = swap;
+		}
+
+		SubtractFrom(b, a);
+	}
+	while (!IsZero(b));
+
+	delete b;
+
+	while (shift > 0)
+	{
+		int step = Min(shift, 13);
+		BigInt* oldA = a;
+		a = Multiply(a, 1 << step);
+		delete oldA;
+		shift -= step;
+	}
+
+	return a;
+}
+
 int DeleteExtraZeros(int startSize, BigInt* digit)
 {
 	int size = startSize;
@@ -3,6 +3,8 @@
 
 #include "Common.h"
 
+class PowerCache;
+
 class BigInt
 {
 public:
@@ -11,24 +13,39 @@ public:
 	static const int maxDigitsCount = 50000;
 	static const int maxDecDigitsCount = 100000;
 
+	//"Цифры" старше size не определены: обнуляются только те, что понадобятся операции
 	int size;
 	int digits[maxDigitsCount];
 
 	BigInt();
 	BigInt(int digit);
+	BigInt(int digit, int limbsCount);
+	BigInt(const BigInt& digit);
+
+	//Числа выделяются через LimbMemory: при включенных огромных страницах - слотами с узла NUMA потока
+	static void* operator new(size_t size);
+	static void operator delete(void* memory);
 };
 
 bool IsZero(const BigInt* digit);
 BigInt* Add(const BigInt* left, const BigInt* right);
+void AddTo(BigInt* left, const BigInt* right);
 bool AreEquals(const BigInt* left, const BigInt* right);
 bool IsGreater(const BigInt* left, const BigInt* right);
 bool IsLess(const BigInt* left, const BigInt* right);
 BigInt* Subtract(const BigInt* left, const BigInt* right);
+void SubtractFrom(BigInt* left, const BigInt* right);
 BigInt* Multiply(const BigInt* left, const BigInt* right);
 BigInt* Multiply(const BigInt* left, int right);
 int FindDivisor(BigInt** divident, const BigInt* divisor);
 BigInt* Divide(const BigInt* left, const BigInt* right);
+BigInt* Divide(const BigInt* left, int right);
 BigInt* Power(const BigInt* left, const BigInt* power);
+BigInt* Power(const BigInt* left, const BigInt* power, PowerCache* cache);
+double CountPowerLimbsLowerBound(const BigInt* left, int exponent);
+BigInt* SquareRoot(const BigInt* digit);
+BigInt* Root(const BigInt* digit, const BigInt* degree);
+BigInt* Gcd(const BigInt* left, const BigInt* right);
 int DeleteExtraZeros(int startSize, BigInt* digit);
 
 #endif
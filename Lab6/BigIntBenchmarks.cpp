@@ -0,0 +1,454 @@
+#include "benchmark/benchmark.h"
+#include "FileOperations.h"
+#include "BigInt.h"
+#include "LimbKernels.h"
+#include "FixedBigInt.h"
+#include "SmallRowBatch.h"
+#include "Combinatorics.h"
+#include "LimbMemory.h"
+#include "BenchmarkAllocations.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// Запуск: Lab6Benchmarks --benchmark_format=json --benchmark_out=result.json
+// time_per_limb - секунды на одну "цифру" (в консоли с приставкой: 1.5n = 1.5 нс),
+// allocs_per_op - вызовы operator new за одну операцию.
+
+static BigInt* CreateDigit(int size, unsigned int seed)
+{
+	BigInt* bigInt = new BigInt();
+	bigInt->size = size;
+	for (int i = 0; i < size; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		bigInt->digits[i] = (seed >> 8) % BigInt::base;
+	}
+	if (bigInt->digits[size - 1] == 0)
+	{
+		bigInt->digits[size - 1] = 1;
+	}
+
+	return bigInt;
+}
+
+static void SetCounters(benchmark::State& state, long long limbs, long long allocations)
+{
+	state.counters["time_per_limb"] = benchmark::Counter((double)limbs, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+	state.counters["allocs_per_op"] = benchmark::Counter((double)allocations, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_Add(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* right = CreateDigit(size, 2);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		BigInt* result = Add(left, right);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	delete left;
+	delete right;
+}
+BENCHMARK(BM_Add)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+
+static void BM_Subtract(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* right = CreateDigit(size, 2);
+	left->digits[size - 1] = BigInt::base - 1;
+	right->digits[size - 1] = 0;
+	right->size = DeleteExtraZeros(size, right);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		BigInt* result = Subtract(left, right);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	delete left;
+	delete right;
+}
+BENCHMARK(BM_Subtract)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount);
+
+static void BM_Multiply(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* right = CreateDigit(size, 2);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		BigInt* result = Multiply(left, right);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, (long long)size * size, allocationsCount - allocations);
+	delete left;
+	delete right;
+}
+BENCHMARK(BM_Multiply)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount / 2);
+
+static void BM_MultiplyShort(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		BigInt* result = Multiply(left, BigInt::base - 1);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	delete left;
+}
+BENCHMARK(BM_MultiplyShort)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+
+//Ядра умножения на короткое без выделения памяти: прежнее с делением и новые без него
+static void BM_MultiplyLimbs(benchmark::State& state, int (*multiply)(int*, const int*, int, int))
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* result = CreateDigit(size, 2);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(multiply(result->digits, left->digits, size, BigInt::base - 1));
+		benchmark::ClobberMemory();
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	delete left;
+	delete result;
+}
+BENCHMARK_CAPTURE(BM_MultiplyLimbs, Division, MultiplyLimbsByDivision)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+BENCHMARK_CAPTURE(BM_MultiplyLimbs, ReciprocalScalar, MultiplyLimbsScalar)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+BENCHMARK_CAPTURE(BM_MultiplyLimbs, Reciprocal, MultiplyLimbs)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+BENCHMARK_CAPTURE(BM_MultiplyLimbs, MultiplyAddScalar, MultiplyAddLimbsScalar)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+BENCHMARK_CAPTURE(BM_MultiplyLimbs, MultiplyAdd, MultiplyAddLimbs)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+
+//Числа фиксированной ширины: 10 "цифр" ~ 128 бит, 80 ~ 1024 бита; limbs считаются по ширине
+template <int Limbs>
+static void BM_FixedAdd(benchmark::State& state)
+{
+	BigInt* digit = CreateDigit(Limbs - 1, 1);
+	FixedBigInt<Limbs> left;
+	FixedBigInt<Limbs> result;
+	FromBigInt(digit, &left);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(left);
+		benchmark::DoNotOptimize(Add(&left, &left, &result));
+		benchmark::DoNotOptimize(result);
+	}
+	SetCounters(state, Limbs, 0);
+	delete digit;
+}
+BENCHMARK_TEMPLATE(BM_FixedAdd, 10);
+BENCHMARK_TEMPLATE(BM_FixedAdd, 80);
+
+template <int Limbs>
+static void BM_FixedMultiply(benchmark::State& state)
+{
+	BigInt* digit = CreateDigit(Limbs, 1);
+	FixedBigInt<Limbs> left;
+	FixedBigInt<2 * Limbs> result;
+	FromBigInt(digit, &left);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(left);
+		Multiply(&left, &left, &result);
+		benchmark::DoNotOptimize(result);
+	}
+	SetCounters(state, Limbs, 0);
+	delete digit;
+}
+BENCHMARK_TEMPLATE(BM_FixedMultiply, 10);
+BENCHMARK_TEMPLATE(BM_FixedMultiply, 80);
+
+//Пачка из lanesCount строк по 8 "цифр"; time_per_limb здесь - время на строку
+static void BM_SmallRows(benchmark::State& state, void (*kernel)(SmallRowBatch*))
+{
+	SmallRowBatch* batch = new SmallRowBatch();
+	batch->count = SmallRowBatch::lanesCount;
+	BigInt* left = CreateDigit(SmallRowBatch::limbsCount * SmallRowBatch::lanesCount, 1);
+	BigInt* right = CreateDigit(SmallRowBatch::limbsCount * SmallRowBatch::lanesCount, 2);
+	for (int limb = 0; limb < SmallRowBatch::limbsCount; limb++)
+	{
+		memcpy(batch->left[limb], left->digits + limb * SmallRowBatch::lanesCount, sizeof(batch->left[limb]));
+		memcpy(batch->right[limb], right->digits + limb * SmallRowBatch::lanesCount, sizeof(batch->right[limb]));
+	}
+
+	for (auto _ : state)
+	{
+		kernel(batch);
+		benchmark::ClobberMemory();
+	}
+	SetCounters(state, SmallRowBatch::lanesCount, 0);
+	delete left;
+	delete right;
+	delete batch;
+}
+BENCHMARK_CAPTURE(BM_SmallRows, Add, AddSmallRows);
+BENCHMARK_CAPTURE(BM_SmallRows, Multiply, MultiplySmallRows);
+BENCHMARK_CAPTURE(BM_SmallRows, Compare, CompareSmallRows);
+
+static void BM_Divide(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* right = CreateDigit((size + 1) / 2, 2);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		BigInt* result = Divide(left, right);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, (long long)size * ((size + 1) / 2), allocationsCount - allocations);
+	delete left;
+	delete right;
+}
+BENCHMARK(BM_Divide)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount);
+
+static void BM_Power(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt power(15);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		BigInt* result = Power(left, &power);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	delete left;
+}
+BENCHMARK(BM_Power)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount / 16);
+
+static void BM_Factorial(benchmark::State& state)
+{
+	BigInt n((int)state.range(0));
+	for (auto _ : state)
+	{
+		BigInt* result = Factorial(&n);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+}
+BENCHMARK(BM_Factorial)->RangeMultiplier(4)->Range(64, 16384);
+
+//То же n!, как цепочка строк *: каждый множитель по очереди
+static void BM_FactorialByRows(benchmark::State& state)
+{
+	int n = (int)state.range(0);
+	for (auto _ : state)
+	{
+		BigInt* result = new BigInt(1);
+		for (int i = 2; i <= n; i++)
+		{
+			BigInt factor(i);
+			BigInt* product = Multiply(result, &factor);
+			delete result;
+			result = product;
+		}
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+}
+BENCHMARK(BM_FactorialByRows)->RangeMultiplier(4)->Range(64, 16384);
+
+//Промахи TLB данных при чтении (perf). Если счетчик недоступен (не Linux, perf_event_paranoid, виртуальная
+//машина без PMU), бенчмарк считает только время
+static int OpenTlbMissesCounter()
+{
+#ifdef __linux__
+	perf_event_attr attributes;
+	memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.type = PERF_TYPE_HW_CACHE;
+	attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attributes.disabled = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	int counter = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+	if (counter >= 0)
+	{
+		ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+		ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	return counter;
+#else
+	return -1;
+#endif
+}
+
+static void CloseTlbMissesCounter(benchmark::State& state, int counter)
+{
+#ifdef __linux__
+	long long misses = 0;
+	if (counter >= 0 && read(counter, &misses, sizeof(misses)) == sizeof(misses))
+	{
+		state.counters["tlb_misses_per_op"] = benchmark::Counter((double)misses, benchmark::Counter::kAvgIterations);
+	}
+	if (counter >= 0)
+	{
+		close(counter);
+	}
+#endif
+}
+
+//Много чисел в случайном порядке, по нескольку "цифр" в каждом: каждое сложение трогает новое число.
+//В обычной куче это новые страницы по 4 КБ, в огромных - одна страница на десяток чисел
+static void BM_ScatteredAdd(benchmark::State& state, HugePages mode)
+{
+	SetHugePages(mode);
+	const int count = 2048;
+	int size = (int)state.range(0);
+	BigInt** numbers = new BigInt*[count];
+	int* order = new int[count];
+	unsigned int seed = 1;
+	for (int i = 0; i < count; i++)
+	{
+		numbers[i] = CreateDigit(size, i + 1);
+		order[i] = i;
+	}
+	for (int i = count - 1; i > 0; i--)
+	{
+		seed = seed * 1103515245 + 12345;
+		int other = (seed >> 8) % (i + 1);
+		int swap = order[i];
+		order[i] = order[other];
+		order[other] = swap;
+	}
+
+	int counter = OpenTlbMissesCounter();
+	for (auto _ : state)
+	{
+		for (int i = 0; i + 1 < count; i++)
+		{
+			BigInt* sum = numbers[order[i]];
+			AddLimbs(sum->digits, sum->digits, numbers[order[i + 1]]->digits, size);
+		}
+		benchmark::ClobberMemory();
+	}
+	CloseTlbMissesCounter(state, counter);
+	state.counters["time_per_limb"] = benchmark::Counter((double)(count - 1) * size, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+
+	for (int i = 0; i < count; i++)
+	{
+		delete numbers[i];
+	}
+	delete[] numbers;
+	delete[] order;
+	SetHugePages(HUGE_PAGES_NONE);
+}
+BENCHMARK_CAPTURE(BM_ScatteredAdd, Heap, HUGE_PAGES_NONE)->Arg(4)->Arg(64);
+BENCHMARK_CAPTURE(BM_ScatteredAdd, Transparent, HUGE_PAGES_TRANSPARENT)->Arg(4)->Arg(64);
+BENCHMARK_CAPTURE(BM_ScatteredAdd, Explicit, HUGE_PAGES_EXPLICIT)->Arg(4)->Arg(64);
+
+//Большое умножение: результат - новое число на каждой итерации
+static void BM_MultiplyInPages(benchmark::State& state, HugePages mode)
+{
+	SetHugePages(mode);
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* right = CreateDigit(size, 2);
+	long long allocations = allocationsCount;
+	int counter = OpenTlbMissesCounter();
+	for (auto _ : state)
+	{
+		BigInt* result = Multiply(left, right);
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	CloseTlbMissesCounter(state, counter);
+	SetCounters(state, (long long)size * size, allocationsCount - allocations);
+	delete left;
+	delete right;
+	SetHugePages(HUGE_PAGES_NONE);
+}
+BENCHMARK_CAPTURE(BM_MultiplyInPages, Heap, HUGE_PAGES_NONE)->Arg(4096)->Arg(16384);
+BENCHMARK_CAPTURE(BM_MultiplyInPages, Transparent, HUGE_PAGES_TRANSPARENT)->Arg(4096)->Arg(16384);
+
+static void BM_Compare(benchmark::State& state, bool (*compare)(const BigInt*, const BigInt*))
+{
+	int size = (int)state.range(0);
+	BigInt* left = CreateDigit(size, 1);
+	BigInt* right = new BigInt(*left);
+	//Числа расходятся только в младшей "цифре", и она остается меньше base (при size 1 9999 дает ноль)
+	right->digits[0] = (right->digits[0] + 1) % BigInt::base;
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(compare(left, right));
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	delete left;
+	delete right;
+}
+BENCHMARK_CAPTURE(BM_Compare, AreEquals, AreEquals)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+BENCHMARK_CAPTURE(BM_Compare, IsGreater, IsGreater)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+BENCHMARK_CAPTURE(BM_Compare, IsLess, IsLess)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount - 1);
+
+static void BM_ReadBigInt(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* digit = CreateDigit(size, 1);
+	FILE* inputFile = tmpfile();
+	fprintf(inputFile, "%d", digit->digits[size - 1]);
+	for (int i = size - 2; i >= 0; i--)
+	{
+		fprintf(inputFile, "%.4d", digit->digits[i]);
+	}
+	fprintf(inputFile, "\n");
+
+	FileOperations operations;
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		rewind(inputFile);
+		BigInt* result = operations.ReadBigInt(inputFile, fgetc(inputFile));
+		benchmark::DoNotOptimize(result);
+		delete result;
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+	fclose(inputFile);
+	delete digit;
+}
+BENCHMARK(BM_ReadBigInt)->RangeMultiplier(8)->Range(1, BigInt::maxDecDigitsCount / BigInt::baseDimentions);
+
+static void BM_PrintBigInt(benchmark::State& state)
+{
+	int size = (int)state.range(0);
+	BigInt* digit = CreateDigit(size, 1);
+
+	FILE* nullFile = fopen("/dev/null", "w");
+	FileOperations operations;
+	operations.SetOutputFile(nullFile);
+	long long allocations = allocationsCount;
+	for (auto _ : state)
+	{
+		operations.PrintBigInt(digit);
+	}
+	SetCounters(state, size, allocationsCount - allocations);
+
+	fclose(nullFile);
+	delete digit;
+}
+BENCHMARK(BM_PrintBigInt)->RangeMultiplier(8)->Range(1, BigInt::maxDigitsCount);
+
+BENCHMARK_MAIN();
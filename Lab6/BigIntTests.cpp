@@ -2,6 +2,14 @@
 #include "FileOperations.h"
 #include "TList.h"
 #include "BigInt.h"
+#include "PreparedDivisor.h"
+#include "LimbKernels.h"
+#include "FixedBigInt.h"
+#include "SmallRowBatch.h"
+#include "Reduction.h"
+#include "Combinatorics.h"
+#include "LimbMemory.h"
+#include <string.h>
 #include "UnitTestsHelper.h"
 
 void SetDigits(BigInt* bigInt, int* digits)
@@ -466,6 +474,341 @@ TEST(DivisionTest, DivideIfDividentIsZero)
 	UnitTestsHelper::AssertDigits(digits, result);
 }
 
+void SetRandomDigits(BigInt* bigInt, int size, unsigned int* seed)
+{
+	bigInt->size = size;
+	for (int i = 0; i < size; i++)
+	{
+		*seed = *seed * 1103515245 + 12345;
+		bigInt->digits[i] = (*seed >> 8) % BigInt::base;
+	}
+	if (bigInt->digits[size - 1] == 0)
+	{
+		bigInt->digits[size - 1] = 1;
+	}
+}
+
+void AssertQuotient(BigInt* left, BigInt* right, BigInt* quotient)
+{
+	BigInt* mult = Multiply(quotient, right);
+	ASSERT_FALSE(IsGreater(mult, left));
+
+	BigInt* remainder = Subtract(left, mult);
+	ASSERT_TRUE(IsLess(remainder, right));
+
+	delete mult;
+	delete remainder;
+}
+
+TEST(PreparedDivisorTest, DivideSeveralDividentsBySameDivisor)
+{
+	BigInt right;
+	right.size = 2;
+	int rightDigits[] = {123, 88};
+	SetDigits(&right, rightDigits);
+
+	BigInt first, second;
+	first.size = 4;
+	second.size = 3;
+	int firstDigits[] = {123, 45, 678, 999};
+	int secondDigits[] = {123, 45, 6};
+	SetDigits(&first, firstDigits);
+	SetDigits(&second, secondDigits);
+
+	PreparedDivisor divisor(&right);
+	const BigInt* dividents[] = {&first, &second};
+	BigInt* results[2];
+	divisor.DivideAll(dividents, 2, results);
+
+	int firstExpect[] = {5656, 3514, 11};
+	int secondExpect[] = {682};
+	ASSERT_EQ(3, results[0]->size);
+	UnitTestsHelper::AssertDigits(firstExpect, results[0]);
+	ASSERT_EQ(1, results[1]->size);
+	UnitTestsHelper::AssertDigits(secondExpect, results[1]);
+	ASSERT_TRUE(divisor.IsFor(&right));
+	ASSERT_FALSE(divisor.IsFor(&first));
+}
+
+TEST(PreparedDivisorTest, DivideRandomDigits)
+{
+	unsigned int seed = 42;
+	for (int test = 0; test < 50; test++)
+	{
+		BigInt left, right;
+		SetRandomDigits(&left, 1 + test * 3, &seed);
+		SetRandomDigits(&right, 1 + test % 17, &seed);
+
+		BigInt* quotient = Divide(&left, &right);
+		AssertQuotient(&left, &right, quotient);
+		delete quotient;
+	}
+}
+
+TEST(PreparedDivisorTest, DivideIfQuotientNeedsCorrection)
+{
+	BigInt left, right;
+	left.size = 4;
+	right.size = 2;
+	int leftDigits[] = {0, 0, 0, 5000};
+	int rightDigits[] = {9999, 5000};
+	SetDigits(&left, leftDigits);
+	SetDigits(&right, rightDigits);
+
+	BigInt* quotient = Divide(&left, &right);
+	AssertQuotient(&left, &right, quotient);
+}
+
+//Серии 9999 и нулей проверяют пропуск переноса через целые блоки
+void SetCarryChainDigits(BigInt* bigInt, int size, unsigned int* seed)
+{
+	SetRandomDigits(bigInt, size, seed);
+	for (int i = 0; i < size; i++)
+	{
+		*seed = *seed * 1103515245 + 12345;
+		int kind = (*seed >> 16) % 4;
+		if (kind == 0)
+		{
+			bigInt->digits[i] = BigInt::base - 1;
+		}
+		else if (kind == 1)
+		{
+			bigInt->digits[i] = 0;
+		}
+	}
+}
+
+TEST(LimbKernelsTest, ShouldMatchScalarKernels)
+{
+	unsigned int seed = 7;
+	BigInt left;
+	BigInt right;
+	BigInt expected;
+	BigInt actual;
+	for (int test = 0; test < 200; test++)
+	{
+		int size = 1 + test * 7 % 97;
+		SetCarryChainDigits(&left, size, &seed);
+		SetCarryChainDigits(&right, size, &seed);
+
+		int expectedCarry = AddLimbsScalar(expected.digits, left.digits, right.digits, size);
+		int actualCarry = AddLimbs(actual.digits, left.digits, right.digits, size);
+		ASSERT_EQ(expectedCarry, actualCarry);
+		ASSERT_EQ(0, memcmp(expected.digits, actual.digits, size * sizeof(int)));
+
+		expectedCarry = SubtractLimbsScalar(expected.digits, left.digits, right.digits, size);
+		actualCarry = SubtractLimbs(actual.digits, left.digits, right.digits, size);
+		ASSERT_EQ(expectedCarry, actualCarry);
+		ASSERT_EQ(0, memcmp(expected.digits, actual.digits, size * sizeof(int)));
+	}
+}
+
+TEST(LimbKernelsTest, ShouldMultiplyWithoutDivision)
+{
+	unsigned int seed = 11;
+	int multipliers[] = {0, 1, 2, 9999, BigInt::base, 1234, 8192};
+	BigInt left;
+	BigInt expected;
+	BigInt actual;
+	BigInt accumulator;
+	for (int test = 0; test < 140; test++)
+	{
+		int size = 1 + test * 13 % 101;
+		int right = test < 70 ? multipliers[test % 7] : (int)(seed >> 8) % BigInt::base;
+		SetCarryChainDigits(&left, size, &seed);
+
+		int expectedCarry = MultiplyLimbsByDivision(expected.digits, left.digits, size, right);
+		ASSERT_EQ(expectedCarry, MultiplyLimbs(actual.digits, left.digits, size, right));
+		ASSERT_EQ(0, memcmp(expected.digits, actual.digits, size * sizeof(int)));
+		ASSERT_EQ(expectedCarry, MultiplyLimbsScalar(actual.digits, left.digits, size, right));
+		ASSERT_EQ(0, memcmp(expected.digits, actual.digits, size * sizeof(int)));
+
+		if (right == BigInt::base)
+		{
+			continue;
+		}
+
+		//result + left * right через сложение с уже проверенным произведением
+		SetCarryChainDigits(&accumulator, size, &seed);
+		int sumCarry = AddLimbsScalar(expected.digits, expected.digits, accumulator.digits, size);
+		memcpy(actual.digits, accumulator.digits, size * sizeof(int));
+		ASSERT_EQ(expectedCarry + sumCarry, MultiplyAddLimbs(actual.digits, left.digits, size, right));
+		ASSERT_EQ(0, memcmp(expected.digits, actual.digits, size * sizeof(int)));
+		memcpy(actual.digits, accumulator.digits, size * sizeof(int));
+		ASSERT_EQ(expectedCarry + sumCarry, MultiplyAddLimbsScalar(actual.digits, left.digits, size, right));
+		ASSERT_EQ(0, memcmp(expected.digits, actual.digits, size * sizeof(int)));
+	}
+}
+
+TEST(FixedBigIntTest, ShouldMatchBigIntArithmetic)
+{
+	unsigned int seed = 5;
+	for (int test = 0; test < 100; test++)
+	{
+		BigInt* left = new BigInt();
+		BigInt* right = new BigInt();
+		SetRandomDigits(left, 1 + test % 9, &seed);
+		SetRandomDigits(right, 1 + test * 7 % 9, &seed);
+
+		FixedBigInt<10> fixedLeft;
+		FixedBigInt<10> fixedRight;
+		ASSERT_TRUE(FromBigInt(left, &fixedLeft));
+		ASSERT_TRUE(FromBigInt(right, &fixedRight));
+
+		FixedBigInt<10> fixedSum;
+		ASSERT_TRUE(Add(&fixedLeft, &fixedRight, &fixedSum));
+		BigInt* expected = Add(left, right);
+		BigInt* actual = ToBigInt(&fixedSum);
+		ASSERT_TRUE(AreEquals(expected, actual));
+		delete expected;
+		delete actual;
+
+		FixedBigInt<20> fixedProduct;
+		Multiply(&fixedLeft, &fixedRight, &fixedProduct);
+		expected = Multiply(left, right);
+		actual = ToBigInt(&fixedProduct);
+		ASSERT_TRUE(AreEquals(expected, actual));
+		delete expected;
+		delete actual;
+
+		int compare = Compare(&fixedLeft, &fixedRight);
+		ASSERT_EQ(IsGreater(left, right), compare > 0);
+		ASSERT_EQ(IsLess(left, right), compare < 0);
+
+		FixedBigInt<10> fixedDifference;
+		ASSERT_EQ(compare >= 0, Subtract(&fixedLeft, &fixedRight, &fixedDifference));
+		if (compare >= 0)
+		{
+			expected = Subtract(left, right);
+			actual = ToBigInt(&fixedDifference);
+			ASSERT_TRUE(AreEquals(expected, actual));
+			delete expected;
+			delete actual;
+		}
+
+		delete left;
+		delete right;
+	}
+}
+
+TEST(FixedBigIntTest, ShouldRejectNumbersWiderThanTemplate)
+{
+	BigInt wide;
+	wide.size = 5;
+	for (int i = 0; i < wide.size; i++)
+	{
+		wide.digits[i] = BigInt::base - 1;
+	}
+
+	FixedBigInt<4> narrow;
+	ASSERT_FALSE(FromBigInt(&wide, &narrow));
+
+	FixedBigInt<5> full;
+	FixedBigInt<5> sum;
+	ASSERT_TRUE(FromBigInt(&wide, &full));
+	ASSERT_FALSE(Add(&full, &full, &sum));
+}
+
+TEST(SmallRowBatchTest, ShouldMatchFixedBigIntInEveryLane)
+{
+	unsigned int seed = 17;
+	SmallRowBatch* batch = new SmallRowBatch();
+	batch->count = 37;
+	FixedBigInt<SmallRowBatch::limbsCount + 1> left[37];
+	FixedBigInt<SmallRowBatch::limbsCount + 1> right[37];
+	for (int lane = 0; lane < batch->count; lane++)
+	{
+		BigInt* digit = new BigInt();
+		SetCarryChainDigits(digit, 1 + lane % SmallRowBatch::limbsCount, &seed);
+		FromBigInt(digit, left + lane);
+		SetCarryChainDigits(digit, 1 + lane * 5 % SmallRowBatch::limbsCount, &seed);
+		FromBigInt(digit, right + lane);
+		delete digit;
+
+		//Равные строки проверяют нулевую разность и сравнение на равенство
+		if (lane % 6 == 0)
+		{
+			right[lane] = left[lane];
+		}
+
+		for (int limb = 0; limb < SmallRowBatch::limbsCount; limb++)
+		{
+			batch->left[limb][lane] = left[lane].digits[limb];
+			batch->right[limb][lane] = right[lane].digits[limb];
+		}
+	}
+
+	AddSmallRows(batch);
+	for (int lane = 0; lane < batch->count; lane++)
+	{
+		FixedBigInt<SmallRowBatch::limbsCount + 1> sum;
+		Add(left + lane, right + lane, &sum);
+		for (int limb = 0; limb <= SmallRowBatch::limbsCount; limb++)
+		{
+			ASSERT_EQ(sum.digits[limb], batch->result[limb][lane]);
+		}
+	}
+
+	SubtractSmallRows(batch);
+	for (int lane = 0; lane < batch->count; lane++)
+	{
+		FixedBigInt<SmallRowBatch::limbsCount + 1> difference;
+		bool borrow = !Subtract(left + lane, right + lane, &difference);
+		ASSERT_EQ(borrow ? 1 : 0, batch->result[SmallRowBatch::limbsCount][lane]);
+		for (int limb = 0; limb < SmallRowBatch::limbsCount && !borrow; limb++)
+		{
+			ASSERT_EQ(difference.digits[limb], batch->result[limb][lane]);
+		}
+	}
+
+	MultiplySmallRows(batch);
+	for (int lane = 0; lane < batch->count; lane++)
+	{
+		FixedBigInt<2 * SmallRowBatch::limbsCount + 2> product;
+		Multiply(left + lane, right + lane, &product);
+		for (int limb = 0; limb < 2 * SmallRowBatch::limbsCount; limb++)
+		{
+			ASSERT_EQ(product.digits[limb], batch->result[limb][lane]);
+		}
+	}
+
+	CompareSmallRows(batch);
+	for (int lane = 0; lane < batch->count; lane++)
+	{
+		int compare = Compare(left + lane, right + lane);
+		ASSERT_EQ((compare > 0) - (compare < 0), batch->result[0][lane]);
+	}
+
+	delete batch;
+}
+
+TEST(AddTest, ShouldCarryThroughLongerOperand)
+{
+	BigInt left;
+	BigInt right(1);
+	left.size = 20;
+	for (int i = 0; i < left.size; i++)
+	{
+		left.digits[i] = BigInt::base - 1;
+	}
+
+	BigInt* sum = Add(&right, &left);
+	ASSERT_EQ(21, sum->size);
+	ASSERT_EQ(1, sum->digits[20]);
+	for (int i = 0; i < 20; i++)
+	{
+		ASSERT_EQ(0, sum->digits[i]);
+	}
+
+	BigInt* difference = Subtract(sum, &right);
+	ASSERT_TRUE(AreEquals(&left, difference));
+
+	AddTo(&left, &right);
+	ASSERT_TRUE(AreEquals(sum, &left));
+	delete sum;
+	delete difference;
+}
+
 TEST(PowerTest, PowerIfPowerIsShort)
 {
 	BigInt left, right;
@@ -522,6 +865,153 @@ TEST(PowerTest, PowerIfPowerIsBig)
 	UnitTestsHelper::AssertDigits(digits, result);
 }
 
+TEST(ShortDivisionTest, DivideIfShort)
+{
+	BigInt left;
+	left.size = 3;
+
+	int leftDigits[] = {123, 45, 6};
+	SetDigits(&left, leftDigits);
+
+	BigInt* result = Divide(&left, 7);
+	int digits[] = {8589, 8577};
+
+	ASSERT_EQ(2, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(SquareRootTest, SquareRootIfNotExact)
+{
+	BigInt digit;
+	digit.size = 6;
+
+	int digitDigits[] = {7890, 3456, 9012, 5678, 1234, 9999};
+	SetDigits(&digit, digitDigits);
+
+	BigInt* result = SquareRoot(&digit);
+	int digits[] = {1878, 5617, 9999};
+
+	ASSERT_EQ(3, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(SquareRootTest, SquareRootIfAllNines)
+{
+	BigInt digit;
+	digit.size = 6;
+
+	int digitDigits[] = {9999, 9999, 9999, 9999, 9999, 9999};
+	SetDigits(&digit, digitDigits);
+
+	BigInt* result = SquareRoot(&digit);
+	int digits[] = {9999, 9999, 9999};
+
+	ASSERT_EQ(3, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(SquareRootTest, SquareRootIfZero)
+{
+	BigInt digit(0);
+
+	BigInt* result = SquareRoot(&digit);
+
+	ASSERT_TRUE(IsZero(result));
+}
+
+TEST(RootTest, CubeRoot)
+{
+	BigInt digit, degree(3);
+	digit.size = 8;
+
+	int digitDigits[] = {7890, 3456, 9012, 5678, 1234, 7890, 3456, 12};
+	SetDigits(&digit, digitDigits);
+
+	BigInt* result = Root(&digit, &degree);
+	int digits[] = {8592, 7933, 49};
+
+	ASSERT_EQ(3, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(RootTest, RootIfDegreeIsBig)
+{
+	BigInt digit, degree(100);
+	digit.size = 8;
+
+	int digitDigits[] = {7890, 3456, 9012, 5678, 1234, 7890, 3456, 12};
+	SetDigits(&digit, digitDigits);
+
+	BigInt* result = Root(&digit, &degree);
+	int digits[] = {1};
+
+	ASSERT_EQ(1, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(RootTest, NotRootIfDegreeIsZero)
+{
+	BigInt digit(8), degree(0);
+	try
+	{
+		Root(&digit, &degree);
+	}
+	catch (AppException e)
+	{
+		ASSERT_STREQ("Error", e.GetMessage());
+		return;
+	}
+
+	ASSERT_FALSE(true);
+}
+
+TEST(GcdTest, GcdIfCommonPowersOfTwo)
+{
+	BigInt left, right;
+	left.size = 6;
+	right.size = 6;
+
+	int leftDigits[] = {5232, 2585, 1323, 9947, 3631, 268};
+	int rightDigits[] = {9264, 5629, 1281, 4369, 3876, 3202};
+	SetDigits(&left, leftDigits);
+	SetDigits(&right, rightDigits);
+
+	BigInt* result = Gcd(&left, &right);
+	int digits[] = {7568, 8359, 7639, 4999, 1980, 1};
+
+	ASSERT_EQ(6, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(GcdTest, GcdIfCoprime)
+{
+	BigInt left, right;
+	left.size = 3;
+	right.size = 1;
+
+	int leftDigits[] = {1, 0, 8589};
+	int rightDigits[] = {15};
+	SetDigits(&left, leftDigits);
+	SetDigits(&right, rightDigits);
+
+	BigInt* result = Gcd(&left, &right);
+	int digits[] = {1};
+
+	ASSERT_EQ(1, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
+TEST(GcdTest, GcdIfOneIsZero)
+{
+	BigInt left(0), right(1234);
+
+	BigInt* result = Gcd(&left, &right);
+	int digits[] = {1234};
+
+	ASSERT_EQ(1, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+}
+
 //TEST(PowerTest, PowerIfNoOverflow)
 //{
 //	BigInt left, right;
@@ -539,28 +1029,309 @@ TEST(PowerTest, PowerIfPowerIsBig)
 //	ASSERT_EQ(50000, result->size);
 //	//UnitTestsHelper::AssertDigits(digits, result);
 //}
-//
-//TEST(PowerTest, ErrorPowerIfOverflow)
-//{
-//	BigInt left, right;
-//	left.size = 2;
-//	right.size = 2;
-//
-//	int leftDigits[] = {9999, 9999};
-//	int rightDigits[] = {5001, 2};
-//	SetDigits(&left, leftDigits);
-//	SetDigits(&right, rightDigits);
-//	try
-//	{
-//		BigInt* result = Power(&left, &right);
-//	}
-//	catch(AppException ex)
-//	{
-//		ASSERT_EQ("Error", ex.GetMessage());
-//		return;
-//	}
-//
-//	ASSERT_FALSE(true);
-//	//ASSERT_EQ(25002, result->size);
-//	//UnitTestsHelper::AssertDigits(digits, result);
-//}
+
+//Длина степени известна заранее: переполнение видно до умножений
+TEST(PowerTest, ErrorPowerIfOverflow)
+{
+	BigInt left, right;
+	left.size = 2;
+	right.size = 2;
+
+	int leftDigits[] = {9999, 9999};
+	int rightDigits[] = {5001, 2};
+	SetDigits(&left, leftDigits);
+	SetDigits(&right, rightDigits);
+	try
+	{
+		Power(&left, &right);
+	}
+	catch (AppException e)
+	{
+		ASSERT_STREQ("Error", e.GetMessage());
+		return;
+	}
+
+	ASSERT_FALSE(true);
+}
+
+TEST(PowerTest, PowerOfZeroAndOneIfPowerIsHuge)
+{
+	BigInt zero(0), one(1), power(0, 3);
+	power.size = 3;
+	power.digits[2] = 1;
+
+	BigInt* zeroResult = Power(&zero, &power);
+	BigInt* oneResult = Power(&one, &power);
+
+	ASSERT_TRUE(IsZero(zeroResult));
+	ASSERT_TRUE(AreEquals(&one, oneResult));
+	delete zeroResult;
+	delete oneResult;
+}
+
+TEST(ReductionTest, ShouldGiveSameSumAsSequentialAdd)
+{
+	Reduction reduction('+');
+	BigInt* expected = new BigInt(0);
+	for (int i = 0; i < 500; i++)
+	{
+		BigInt* digit = new BigInt(0, 1 + i % 7);
+		for (int limb = 0; limb < 1 + i % 7; limb++)
+		{
+			digit->digits[limb] = BigInt::base - 1 - limb;
+		}
+		digit->size = 1 + i % 7;
+
+		BigInt* sum = Add(expected, digit);
+		delete expected;
+		expected = sum;
+		reduction.Add(digit);
+	}
+
+	BigInt* result = reduction.GetResult();
+	ASSERT_TRUE(AreEquals(expected, result));
+	delete expected;
+	delete result;
+}
+
+TEST(ReductionTest, ShouldGiveSameProductAsSequentialMultiply)
+{
+	Reduction reduction('*');
+	BigInt* expected = new BigInt(1);
+	for (int i = 2; i < 300; i++)
+	{
+		BigInt digit(i * 37);
+		BigInt* product = Multiply(expected, &digit);
+		delete expected;
+		expected = product;
+		reduction.Add(new BigInt(i * 37));
+	}
+
+	BigInt* result = reduction.GetResult();
+	ASSERT_TRUE(AreEquals(expected, result));
+	delete expected;
+	delete result;
+}
+
+TEST(ReductionTest, ProductIsZeroIfAnyOperandIsZero)
+{
+	Reduction reduction('*');
+	reduction.Add(new BigInt(12345));
+	reduction.Add(new BigInt(0));
+	reduction.Add(new BigInt(678));
+
+	BigInt* result = reduction.GetResult();
+	ASSERT_TRUE(IsZero(result));
+	delete result;
+}
+
+TEST(ReductionTest, ProductIsZeroIfZeroFollowsOverflow)
+{
+	Reduction reduction('*');
+	for (int i = 0; i < 2; i++)
+	{
+		BigInt* digit = new BigInt(1, 30000);
+		digit->size = 30000;
+		digit->digits[29999] = 1;
+		reduction.Add(digit);
+	}
+	reduction.Add(new BigInt(0));
+
+	BigInt* result = reduction.GetResult();
+	ASSERT_TRUE(IsZero(result));
+	delete result;
+}
+
+TEST(ReductionTest, ErrorProductIfOverflowWithoutZero)
+{
+	Reduction reduction('*');
+	for (int i = 0; i < 3; i++)
+	{
+		BigInt* digit = new BigInt(1, 30000);
+		digit->size = 30000;
+		digit->digits[29999] = 1;
+		reduction.Add(digit);
+	}
+
+	try
+	{
+		reduction.GetResult();
+	}
+	catch (AppException e)
+	{
+		ASSERT_STREQ("Error", e.GetMessage());
+		return;
+	}
+
+	ASSERT_FALSE(true);
+}
+
+TEST(CombinatoricsTest, FactorialIfSmall)
+{
+	BigInt zero(0), twenty(20);
+	int digits[] = {0, 7664, 81, 2902, 243};
+
+	BigInt* zeroResult = Factorial(&zero);
+	BigInt* result = Factorial(&twenty);
+
+	ASSERT_EQ(1, zeroResult->size);
+	ASSERT_EQ(1, zeroResult->digits[0]);
+	ASSERT_EQ(5, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+	delete zeroResult;
+	delete result;
+}
+
+TEST(CombinatoricsTest, FactorialIsRangeProductFromOne)
+{
+	BigInt one(1), n(3000);
+
+	BigInt* factorial = Factorial(&n);
+	BigInt* product = RangeProduct(&one, &n);
+
+	ASSERT_TRUE(AreEquals(factorial, product));
+	delete factorial;
+	delete product;
+}
+
+TEST(CombinatoricsTest, BinomialIsFactorialQuotient)
+{
+	BigInt n(1000), k(377), from(624);
+
+	BigInt* binomial = Binomial(&n, &k);
+	BigInt* denominator = Factorial(&k);
+	BigInt* numerator = RangeProduct(&from, &n);
+	BigInt* product = Multiply(binomial, denominator);
+
+	//C(n, k) * k! = (n - k + 1) * ... * n
+	ASSERT_TRUE(AreEquals(numerator, product));
+	delete binomial;
+	delete denominator;
+	delete numerator;
+	delete product;
+}
+
+TEST(CombinatoricsTest, BinomialIfBeyondSieve)
+{
+	BigInt n(0, 2), k(3);
+	n.size = 2;
+	n.digits[0] = 0;
+	n.digits[1] = 1000;
+	int digits[] = {0, 7000, 6666, 6616, 6666, 1};
+
+	BigInt* result = Binomial(&n, &k);
+
+	ASSERT_EQ(6, result->size);
+	UnitTestsHelper::AssertDigits(digits, result);
+	delete result;
+}
+
+TEST(CombinatoricsTest, BinomialIfNumeratorLongerThanResult)
+{
+	BigInt n(4194305), previous(4194304), k(31000), previousK(30999);
+
+	//(n - k + 1) * ... * n длиннее maxDigitsCount, а C(n, k) помещается; n - 1 = 2^22 еще считается решетом
+	BigInt* result = Binomial(&n, &k);
+	BigInt* left = Binomial(&previous, &k);
+	BigInt* right = Binomial(&previous, &previousK);
+	BigInt* sum = Add(left, right);
+
+	ASSERT_TRUE(AreEquals(sum, result));
+	delete result;
+	delete left;
+	delete right;
+	delete sum;
+}
+
+TEST(CombinatoricsTest, BinomialOfLongNumberIfBottomIsSmall)
+{
+	BigInt n(0, 3), zero(0), one(1), two(2), previous(99999999);
+	n.size = 3;
+	n.digits[2] = 1;
+
+	BigInt* results[] = {Binomial(&n, &zero), Binomial(&n, &n), Binomial(&n, &one), Binomial(&n, &previous)};
+
+	ASSERT_EQ(1, results[0]->size);
+	ASSERT_EQ(1, results[0]->digits[0]);
+	ASSERT_EQ(1, results[1]->size);
+	ASSERT_EQ(1, results[1]->digits[0]);
+	ASSERT_TRUE(AreEquals(&n, results[2]));
+	ASSERT_TRUE(AreEquals(&n, results[3]));
+	for (int i = 0; i < 4; i++)
+	{
+		delete results[i];
+	}
+
+	try
+	{
+		Binomial(&n, &two);
+	}
+	catch (AppException e)
+	{
+		ASSERT_STREQ("Error", e.GetMessage());
+		return;
+	}
+
+	ASSERT_FALSE(true);
+}
+
+TEST(CombinatoricsTest, RangeProductIfEmptyOrWithZero)
+{
+	BigInt zero(0), five(5), ten(10);
+
+	BigInt* empty = RangeProduct(&ten, &five);
+	BigInt* withZero = RangeProduct(&zero, &five);
+
+	ASSERT_EQ(1, empty->size);
+	ASSERT_EQ(1, empty->digits[0]);
+	ASSERT_TRUE(IsZero(withZero));
+	delete empty;
+	delete withZero;
+}
+
+TEST(CombinatoricsTest, ErrorFactorialIfOverflow)
+{
+	BigInt n(50000);
+	try
+	{
+		Factorial(&n);
+	}
+	catch (AppException e)
+	{
+		ASSERT_STREQ("Error", e.GetMessage());
+		return;
+	}
+
+	ASSERT_FALSE(true);
+}
+
+TEST(LimbMemoryTest, ShouldGiveSameResultsInHugePages)
+{
+	BigInt left(99999999);
+	BigInt right(12345678);
+	BigInt* expected = Multiply(&left, &right);
+
+	HugePages modes[] = {HUGE_PAGES_TRANSPARENT, HUGE_PAGES_EXPLICIT};
+	for (int i = 0; i < 2; i++)
+	{
+		SetHugePages(modes[i]);
+		BigInt* first = new BigInt(99999999);
+		BigInt* second = new BigInt(12345678);
+		BigInt* product = Multiply(first, second);
+		delete first;
+		BigInt* reused = new BigInt(1);
+
+		ASSERT_TRUE(AreEquals(expected, product));
+		ASSERT_EQ(1, reused->size);
+		ASSERT_EQ(1, reused->digits[0]);
+		delete second;
+		delete product;
+		delete reused;
+	}
+
+	SetHugePages(HUGE_PAGES_NONE);
+	BigInt* afterwards = Multiply(&left, &right);
+	ASSERT_TRUE(AreEquals(expected, afterwards));
+	delete afterwards;
+	delete expected;
+}
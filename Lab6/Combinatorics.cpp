@@ -0,0 +1,375 @@
+#include "Combinatorics.h"
+#include "Reduction.h"
+#include <math.h>
+#include <string.h>
+
+//Множители копятся в long long, пока произведение меньше 2^31; кусок умножает лист дерева на месте
+static const long long maxChunk = 0x7FFFFFFF;
+//Лист такой длины уходит в дерево; короче - дешевле домножать на месте, чем выделять число
+static const int leafLimbs = 128;
+//До этого n факториал - просто произведение диапазона: разложение на простые не окупает лишних чисел
+static const int maxDirectFactorial = 256;
+//До этого n простые для C(n, k) ищутся решетом до n, для больших n - только до k
+static const int maxSievedNumber = 1 << 22;
+
+//Аргумент длиннее двух "цифр" не считается: факториал такого числа длиннее maxDigitsCount, а C(n, k)
+//с таким n считается только при k или n - k не больше единицы (см. Binomial)
+static int ToInt(const BigInt* digit)
+{
+	if (digit->size > 2)
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	return digit->digits[0] + (digit->size > 1 ? digit->digits[1] * BigInt::base : 0);
+}
+
+//lgamma пишет знак в глобальный signgam - при нескольких потоках это гонка, lgamma_r его не трогает
+static double LogGamma(double x)
+{
+#ifdef __linux__
+	int sign;
+	return lgamma_r(x, &sign);
+#else
+	return lgamma(x);
+#endif
+}
+
+//Заведомо длинный результат отклоняется до умножений: log10(to! / (from - 1)!) через LogGamma
+static void CheckRangeLength(int from, int to, int denominator)
+{
+	double decDigits = (LogGamma(to + 1.0) - LogGamma((double)from) - LogGamma(denominator + 1.0)) / log(10.0);
+	if (decDigits / BigInt::baseDimentions > BigInt::maxDigitsCount + 1)
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+}
+
+// Произведение множителей, поданных по одному: короткие листы растут на месте, длинные перемножает Reduction
+class FactorsProduct
+{
+public:
+	FactorsProduct();
+	~FactorsProduct();
+
+	void Add(int factor);
+	void Add(BigInt* digit);
+	BigInt* GetResult();
+
+private:
+	void MultiplyLeaf();
+
+	Reduction _reduction;
+	BigInt* _leaf;
+	long long _chunk;
+};
+
+FactorsProduct::FactorsProduct() : _reduction('*')
+{
+	_leaf = new BigInt(1);
+	_chunk = 1;
+}
+
+FactorsProduct::~FactorsProduct()
+{
+	delete _leaf;
+}
+
+//Кусок меньше 2^31, "цифра" на него - меньше 2^45: перенос считается в long long
+void FactorsProduct::MultiplyLeaf()
+{
+	long long carry = 0;
+	for (int i = 0; i < _leaf->size; i++)
+	{
+		long long value = _leaf->digits[i] * _chunk + carry;
+		carry = value / BigInt::base;
+		_leaf->digits[i] = (int)(value - carry * BigInt::base);
+	}
+
+	for (; carry > 0; carry /= BigInt::base)
+	{
+		_leaf->digits[_leaf->size++] = (int)(carry % BigInt::base);
+	}
+	_chunk = 1;
+
+	if (_leaf->size >= leafLimbs)
+	{
+		BigInt* leaf = _leaf;
+		_leaf = new BigInt(1);
+		_reduction.Add(leaf);
+	}
+}
+
+void FactorsProduct::Add(int factor)
+{
+	if (_chunk * factor > maxChunk)
+	{
+		MultiplyLeaf();
+	}
+
+	_chunk *= factor;
+}
+
+void FactorsProduct::Add(BigInt* digit)
+{
+	_reduction.Add(digit);
+}
+
+BigInt* FactorsProduct::GetResult()
+{
+	MultiplyLeaf();
+	BigInt* leaf = _leaf;
+	_leaf = NULL;
+	_reduction.Add(leaf);
+	return _reduction.GetResult();
+}
+
+static BigInt* MultiplyRange(int from, int to)
+{
+	FactorsProduct product;
+	for (int i = from; i <= to; i++)
+	{
+		product.Add(i);
+	}
+
+	return product.GetResult();
+}
+
+//Решето Эратосфена; primes - не меньше limit / 2 + 1 элементов
+static int FindPrimes(int limit, int* primes)
+{
+	char* composite = new char[limit + 1];
+	memset(composite, 0, limit + 1);
+	int count = 0;
+	for (int i = 2; i <= limit; i++)
+	{
+		if (composite[i])
+		{
+			continue;
+		}
+
+		primes[count++] = i;
+		for (long long j = (long long)i * i; j <= limit; j += i)
+		{
+			composite[j] = 1;
+		}
+	}
+
+	delete[] composite;
+	return count;
+}
+
+//Показатель простого в n! (формула Лежандра)
+static int CountFactorialExponent(int n, int prime)
+{
+	int exponent = 0;
+	for (long long power = prime; power <= n; power *= prime)
+	{
+		exponent += (int)(n / power);
+	}
+
+	return exponent;
+}
+
+//Со старшего бита показателей: result = result^2 * (произведение простых, у которых этот бит есть)
+static BigInt* MultiplyPrimePowers(const int* primes, const int* exponents, int count)
+{
+	int maxExponent = 0;
+	for (int i = 0; i < count; i++)
+	{
+		maxExponent = Max(maxExponent, exponents[i]);
+	}
+
+	int bit = 0;
+	while ((maxExponent >> bit) > 1)
+	{
+		bit++;
+	}
+
+	BigInt* result = new BigInt(1);
+	for (; bit >= 0; bit--)
+	{
+		FactorsProduct product;
+		for (int i = 0; i < count; i++)
+		{
+			if ((exponents[i] >> bit) & 1)
+			{
+				product.Add(primes[i]);
+			}
+		}
+
+		//Квадрат идет в дерево последним: его не перемножают заново с каждым куском простых
+		BigInt* square = NULL;
+		try
+		{
+			square = Multiply(result, result);
+		}
+		catch(AppException ex)
+		{
+			delete result;
+			throw;
+		}
+
+		delete result;
+		product.Add(square);
+		result = product.GetResult();
+	}
+
+	return result;
+}
+
+static BigInt* GetFactorial(int n)
+{
+	if (n <= maxDirectFactorial)
+	{
+		return MultiplyRange(2, n);
+	}
+
+	int* primes = new int[n / 2 + 1];
+	int count = FindPrimes(n, primes);
+	int* exponents = new int[count];
+	for (int i = 0; i < count; i++)
+	{
+		exponents[i] = CountFactorialExponent(n, primes[i]);
+	}
+
+	BigInt* result = NULL;
+	try
+	{
+		result = MultiplyPrimePowers(primes, exponents, count);
+	}
+	catch(AppException ex)
+	{
+		delete[] primes;
+		delete[] exponents;
+		throw;
+	}
+
+	delete[] primes;
+	delete[] exponents;
+	return result;
+}
+
+BigInt* Factorial(const BigInt* digit)
+{
+	int n = ToInt(digit);
+	CheckRangeLength(1, n, 0);
+	return GetFactorial(n);
+}
+
+//Показатель простого в C(n, k) - по формуле Лежандра для n!, k! и (n - k)!
+static BigInt* GetSievedBinomial(int n, int k)
+{
+	int* primes = new int[n / 2 + 1];
+	int count = FindPrimes(n, primes);
+	int* exponents = new int[count];
+	for (int i = 0; i < count; i++)
+	{
+		exponents[i] = CountFactorialExponent(n, primes[i]) - CountFactorialExponent(k, primes[i])
+			- CountFactorialExponent(n - k, primes[i]);
+	}
+
+	BigInt* result = NULL;
+	try
+	{
+		result = MultiplyPrimePowers(primes, exponents, count);
+	}
+	catch(AppException ex)
+	{
+		delete[] primes;
+		delete[] exponents;
+		throw;
+	}
+
+	delete[] primes;
+	delete[] exponents;
+	return result;
+}
+
+//Для n больше решета k мало (иначе результат не поместится). Множители (n - k + 1) ... n делятся на простые
+//из k! еще до умножения, сколько раз каждое простое входит в k!: в числителя его не меньше, поэтому деления
+//хватает, а произведение оставшихся множителей - сразу C(n, k), без промежуточных чисел длиннее результата
+static BigInt* GetDividedBinomial(int n, int k)
+{
+	int* primes = new int[k / 2 + 1];
+	int count = FindPrimes(k, primes);
+	int* factors = new int[k];
+	int first = n - k + 1;
+	for (int i = 0; i < k; i++)
+	{
+		factors[i] = first + i;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		int prime = primes[i];
+		int exponent = CountFactorialExponent(k, prime);
+		for (int j = (prime - first % prime) % prime; j < k && exponent > 0; j += prime)
+		{
+			while (exponent > 0 && factors[j] % prime == 0)
+			{
+				factors[j] /= prime;
+				exponent--;
+			}
+		}
+	}
+
+	FactorsProduct product;
+	for (int i = 0; i < k; i++)
+	{
+		product.Add(factors[i]);
+	}
+
+	delete[] primes;
+	delete[] factors;
+	return product.GetResult();
+}
+
+BigInt* Binomial(const BigInt* n, const BigInt* k)
+{
+	if (IsGreater(k, n))
+	{
+		return new BigInt(0);
+	}
+
+	//C(n, 0) = 1 и C(n, 1) = n - еще до ToInt: n здесь может быть длиннее двух "цифр"
+	BigInt* rest = Subtract(n, k);
+	const BigInt* smaller = IsLess(rest, k) ? rest : k;
+	bool isZero = IsZero(smaller);
+	bool isOne = smaller->size == 1 && smaller->digits[0] == 1;
+	delete rest;
+	if (isZero)
+	{
+		return new BigInt(1);
+	}
+
+	if (isOne)
+	{
+		return new BigInt(*n);
+	}
+
+	int top = ToInt(n);
+	int bottom = Min(ToInt(k), top - ToInt(k));
+
+	CheckRangeLength(top - bottom + 1, top, bottom);
+	return top <= maxSievedNumber ? GetSievedBinomial(top, bottom) : GetDividedBinomial(top, bottom);
+}
+
+BigInt* RangeProduct(const BigInt* from, const BigInt* to)
+{
+	//Пустой диапазон дает единицу, диапазон с нулем - ноль
+	if (IsGreater(from, to))
+	{
+		return new BigInt(1);
+	}
+
+	if (IsZero(from))
+	{
+		return new BigInt(0);
+	}
+
+	int first = ToInt(from);
+	int last = ToInt(to);
+	CheckRangeLength(first, last, 0);
+	return MultiplyRange(first, last);
+}
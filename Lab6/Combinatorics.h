@@ -0,0 +1,15 @@
+#ifndef H_COMBINATORICS
+#define H_COMBINATORICS
+
+#include "BigInt.h"
+
+// n!, C(n, k) и произведение from * (from + 1) * ... * to; аргументы - не больше двух "цифр".
+// Подряд идущие множители копятся в int, пока помещаются, и перемножаются деревом Reduction (бинарное
+// разбиение): на каждом уровне перемножаются числа близкой длины. n! и C(n, k) раскладываются на степени
+// простых: простые с одним и тем же битом показателя перемножаются вместе, а биты собираются возведением
+// в квадрат со старшего.
+BigInt* Factorial(const BigInt* digit);
+BigInt* Binomial(const BigInt* n, const BigInt* k);
+BigInt* RangeProduct(const BigInt* from, const BigInt* to);
+
+#endif
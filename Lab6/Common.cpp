@@ -11,4 +11,9 @@ int Max( int a, int b )
 	return a > b ? a : b;
 }
 
+int Min( int a, int b )
+{
+	return a < b ? a : b;
+}
+
 
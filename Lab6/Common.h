@@ -4,6 +4,7 @@
 #include <stdlib.h>
 
 int Max(int a, int b);
+int Min(int a, int b);
 
 struct ErrorMessages
 {
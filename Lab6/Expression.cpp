@@ -0,0 +1,394 @@
+#include "Expression.h"
+#include <string.h>
+#include <ctype.h>
+
+static bool IsOperation(const char* token, int length)
+{
+	return length == 1 && strchr("+-*/^QRG!CP<>=", token[0]) != NULL;
+}
+
+static bool IsComparison(int operation)
+{
+	return operation == '<' || operation == '>' || operation == '=';
+}
+
+static bool IsCommutative(int operation)
+{
+	return operation == '+' || operation == '*' || operation == 'G' || operation == '=';
+}
+
+static bool IsName(const char* token, int length)
+{
+	if (length == 0 || !(isalpha((unsigned char)token[0]) || token[0] == '_'))
+	{
+		return false;
+	}
+
+	for (int i = 1; i < length; i++)
+	{
+		if (!(isalnum((unsigned char)token[i]) || token[i] == '_'))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static const char* NextToken(const char* line, int length, int* position, int* tokenLength)
+{
+	while (*position < length && (line[*position] == ' ' || line[*position] == '\t'))
+	{
+		(*position)++;
+	}
+
+	if (*position == length)
+	{
+		return NULL;
+	}
+
+	const char* token = line + *position;
+	while (*position < length && line[*position] != ' ' && line[*position] != '\t')
+	{
+		(*position)++;
+	}
+
+	*tokenLength = (int)(line + *position - token);
+	return token;
+}
+
+ExpressionEvaluator::ExpressionEvaluator(FileOperations* operations)
+{
+	_operations = operations;
+}
+
+ExpressionEvaluator::~ExpressionEvaluator()
+{
+	ClearNodes();
+	for (int i = 0; i < _variables.GetCount(); i++)
+	{
+		ExpressionVariable* variable = _variables.GetElements() + i;
+		free(variable->name);
+		delete variable->value;
+	}
+}
+
+void ExpressionEvaluator::Execute(const char* line, int length)
+{
+	try
+	{
+		int position = 0;
+		int tokenLength = 0;
+		const char* token = NextToken(line, length, &position, &tokenLength);
+		if (token == NULL)
+		{
+			return;
+		}
+
+		//Присваивание: первое слово - имя переменной, второе - ":="
+		const char* target = NULL;
+		int targetLength = 0;
+		int afterTarget = position;
+		int secondLength = 0;
+		const char* second = NextToken(line, length, &afterTarget, &secondLength);
+		if (second != NULL && secondLength == 2 && second[0] == ':' && second[1] == '=')
+		{
+			if (!IsName(token, tokenLength) || IsOperation(token, tokenLength))
+			{
+				throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+			}
+
+			target = token;
+			targetLength = tokenLength;
+			position = afterTarget;
+			token = NextToken(line, length, &position, &tokenLength);
+		}
+
+		TList<int> stack;
+		while (token != NULL)
+		{
+			int node;
+			if (IsOperation(token, tokenLength))
+			{
+				node = PushOperation(token[0], &stack);
+			}
+			else if (isdigit((unsigned char)token[0]))
+			{
+				node = PushNumber(token, tokenLength);
+			}
+			else
+			{
+				node = PushVariable(token, tokenLength);
+			}
+
+			stack.Add(node);
+			token = NextToken(line, length, &position, &tokenLength);
+		}
+
+		if (stack.GetCount() != 1)
+		{
+			throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+		}
+
+		int root = stack[0];
+		int operation = _nodes[root].operation;
+		if (IsComparison(operation))
+		{
+			if (target != NULL)
+			{
+				throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+			}
+
+			int left = _nodes[root].left;
+			int right = _nodes[root].right;
+			Evaluate(left);
+			Evaluate(right);
+			Result result = _operations->ExecuteOperation(operation, _nodes[left].value, _nodes[right].value);
+			_operations->PrintResult(&result);
+		}
+		else if (target != NULL)
+		{
+			Assign(target, targetLength, root);
+		}
+		else
+		{
+			Evaluate(root);
+			_operations->PrintBigInt(_nodes[root].value);
+		}
+	}
+	catch(AppException ex)
+	{
+		_operations->PrintError(ex.GetMessage());
+	}
+
+	ClearNodes();
+}
+
+int ExpressionEvaluator::PushNumber(const char* token, int length)
+{
+	for (int i = 0; i < length; i++)
+	{
+		if (!isdigit((unsigned char)token[i]))
+		{
+			throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+		}
+	}
+
+	BigInt* value = _operations->ParseBigInt(token, length);
+	for (int i = 0; i < _nodes.GetCount(); i++)
+	{
+		ExpressionNode* node = _nodes.GetElements() + i;
+		if (node->operation == 0 && node->variable < 0 && AreEquals(node->value, value))
+		{
+			delete value;
+			node->uses++;
+			return i;
+		}
+	}
+
+	return AddNode(0, -1, -1, -1, true, value);
+}
+
+int ExpressionEvaluator::PushVariable(const char* token, int length)
+{
+	int index = FindVariable(token, length);
+	if (index < 0 || _variables[index].value == NULL)
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	for (int i = 0; i < _nodes.GetCount(); i++)
+	{
+		ExpressionNode* node = _nodes.GetElements() + i;
+		if (node->variable == index)
+		{
+			node->uses++;
+			return i;
+		}
+	}
+
+	return AddNode(0, -1, -1, index, false, _variables[index].value);
+}
+
+int ExpressionEvaluator::PushOperation(int operation, TList<int>* stack)
+{
+	int arity = operation == 'Q' || operation == '!' ? 1 : 2;
+	if (stack->GetCount() < arity)
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	int right = arity == 2 ? stack->RemoveLast() : -1;
+	int left = stack->RemoveLast();
+	if (IsComparison(_nodes[left].operation) || (right >= 0 && IsComparison(_nodes[right].operation)))
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	if (IsCommutative(operation) && right < left)
+	{
+		int swap = left;
+		left = right;
+		right = swap;
+	}
+
+	//Такое подвыражение уже есть в строке: ссылки операндов переходят к нему
+	for (int i = 0; i < _nodes.GetCount(); i++)
+	{
+		ExpressionNode* node = _nodes.GetElements() + i;
+		if (node->operation == operation && node->left == left && node->right == right)
+		{
+			Release(left);
+			if (right >= 0)
+			{
+				Release(right);
+			}
+
+			node->uses++;
+			return i;
+		}
+	}
+
+	return AddNode(operation, left, right, -1, false, NULL);
+}
+
+int ExpressionEvaluator::AddNode(int operation, int left, int right, int variable, bool owned, BigInt* value)
+{
+	ExpressionNode node;
+	node.operation = operation;
+	node.left = left;
+	node.right = right;
+	node.variable = variable;
+	node.uses = 1;
+	node.owned = owned;
+	node.value = value;
+	_nodes.Add(node);
+
+	return _nodes.GetCount() - 1;
+}
+
+int ExpressionEvaluator::FindVariable(const char* name, int length)
+{
+	for (int i = 0; i < _variables.GetCount(); i++)
+	{
+		ExpressionVariable* variable = _variables.GetElements() + i;
+		if (variable->nameLength == length && strncmp(variable->name, name, length) == 0)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void ExpressionEvaluator::Evaluate(int index)
+{
+	ExpressionNode* node = _nodes.GetElements() + index;
+	if (node->value != NULL)
+	{
+		return;
+	}
+
+	Evaluate(node->left);
+	if (node->right >= 0)
+	{
+		Evaluate(node->right);
+	}
+
+	ExpressionNode* left = _nodes.GetElements() + node->left;
+	ExpressionNode* right = node->right >= 0 ? _nodes.GetElements() + node->right : left;
+
+	//Сложение и вычитание накапливаем на месте, если левый операнд больше нигде не нужен
+	if ((node->operation == '+' || node->operation == '-') && left->owned && left->uses == 1 && left != right)
+	{
+		if (node->operation == '+')
+		{
+			AddTo(left->value, right->value);
+		}
+		else
+		{
+			SubtractFrom(left->value, right->value);
+		}
+
+		node->value = left->value;
+		left->value = NULL;
+	}
+	else
+	{
+		Result result = _operations->ExecuteOperation(node->operation, left->value, right->value);
+		node->value = result.digit;
+		result.digit = NULL;
+	}
+
+	node->owned = true;
+	Release(node->left);
+	if (node->right >= 0)
+	{
+		Release(node->right);
+	}
+}
+
+void ExpressionEvaluator::Release(int index)
+{
+	ExpressionNode* node = _nodes.GetElements() + index;
+	node->uses--;
+	if (node->uses == 0 && node->owned)
+	{
+		delete node->value;
+		node->value = NULL;
+	}
+}
+
+void ExpressionEvaluator::Assign(const char* name, int length, int root)
+{
+	//Переменная меняется, только когда строка выполнилась целиком: при ошибке остается старое значение
+	int index = FindVariable(name, length);
+	Evaluate(root);
+
+	ExpressionNode* node = _nodes.GetElements() + root;
+	BigInt* value;
+	if (node->owned && node->uses == 1)
+	{
+		value = node->value;
+		node->value = NULL;
+	}
+	else
+	{
+		value = new BigInt(*node->value);
+	}
+	Release(root);
+
+	if (index < 0)
+	{
+		ExpressionVariable variable;
+		variable.name = (char*) malloc(length);
+		if (variable.name == NULL)
+		{
+			throw AppException(ErrorMessages::MEMORY_ERROR);
+		}
+		memcpy(variable.name, name, length);
+		variable.nameLength = length;
+		variable.value = value;
+		_variables.Add(variable);
+	}
+	else
+	{
+		ExpressionVariable* variable = _variables.GetElements() + index;
+		delete variable->value;
+		variable->value = value;
+	}
+}
+
+void ExpressionEvaluator::ClearNodes()
+{
+	for (int i = 0; i < _nodes.GetCount(); i++)
+	{
+		ExpressionNode* node = _nodes.GetElements() + i;
+		if (node->owned)
+		{
+			delete node->value;
+		}
+	}
+
+	_nodes.Clear();
+}
@@ -0,0 +1,51 @@
+#ifndef H_EXPRESSION
+#define H_EXPRESSION
+
+#include "FileOperations.h"
+#include "TList.h"
+
+struct ExpressionNode
+{
+	int operation;
+	int left;
+	int right;
+	int variable;
+	int uses;
+	bool owned;
+	BigInt* value;
+};
+
+struct ExpressionVariable
+{
+	char* name;
+	int nameLength;
+	BigInt* value;
+};
+
+// Вычисляет строки вида "name := <RPN>" и "<RPN>".
+// Одинаковые подвыражения строки вычисляются один раз, промежуточные значения не печатаются.
+class ExpressionEvaluator
+{
+public:
+	ExpressionEvaluator(FileOperations* operations);
+	~ExpressionEvaluator();
+
+	void Execute(const char* line, int length);
+
+private:
+	int PushNumber(const char* token, int length);
+	int PushVariable(const char* token, int length);
+	int PushOperation(int operation, TList<int>* stack);
+	int AddNode(int operation, int left, int right, int variable, bool owned, BigInt* value);
+	int FindVariable(const char* name, int length);
+	void Evaluate(int node);
+	void Release(int node);
+	void Assign(const char* name, int length, int node);
+	void ClearNodes();
+
+	FileOperations* _operations;
+	TList<ExpressionNode> _nodes;
+	TList<ExpressionVariable> _variables;
+};
+
+#endif
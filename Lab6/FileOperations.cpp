@@ -1,117 +1,1637 @@
 #include "FileOperations.h"
+#include "Expression.h"
+#include "FixedBigInt.h"
+#include "Combinatorics.h"
+#include <string.h>
+
+const char FileOperations::binaryJobMagic[4] = {'L', '6', 'J', 'B'};
+
+FileOperations::FileOperations()
+{
+	_cache = NULL;
+	_cacheBytes = 0;
+	_powerCache = NULL;
+	_powerCacheBytes = 0;
+	_outputFile = stdout;
+	_outputFormat = OUTPUT_DECIMAL;
+	_errorFile = NULL;
+	_binaryInput = false;
+	_threadsCount = 1;
+	_batchSize = 1;
+	_rowBatches = false;
+	_smallRows = NULL;
+	_pool = NULL;
+	_executors = NULL;
+	_statistics = NULL;
+	_cacheCountersPrinting = true;
+	_bytesRead = 0;
+	_lineOffset = 0;
+	_pinning = PIN_NONE;
+}
+
+FileOperations::~FileOperations()
+{
+	delete _pool;
+	delete[] _executors;
+	delete _smallRows;
+	delete _statistics;
+	delete _cache;
+	delete _powerCache;
+	for (int i = 0; i < _divisors.GetCount(); i++)
+	{
+		delete _divisors[i];
+	}
+}
+
+void FileOperations::EnableCache(size_t maxBytes)
+{
+	delete _cache;
+	_cache = new ResultCache(maxBytes);
+	_cacheBytes = maxBytes;
+}
+
+ResultCache* FileOperations::GetCache()
+{
+	return _cache;
+}
+
+void FileOperations::EnablePowerCache(size_t maxBytes)
+{
+	delete _powerCache;
+	_powerCache = new PowerCache(maxBytes);
+	_powerCacheBytes = maxBytes;
+}
+
+PowerCache* FileOperations::GetPowerCache()
+{
+	return _powerCache;
+}
+
+void FileOperations::SetOutputFile(FILE* outputFile)
+{
+	_outputFile = outputFile;
+}
+
+void FileOperations::SetOutputFormat(OutputFormat outputFormat)
+{
+	_outputFormat = outputFormat;
+}
+
+void FileOperations::SetErrorFile(FILE* errorFile)
+{
+	_errorFile = errorFile;
+}
+
+void FileOperations::SetThreadsCount(int threadsCount)
+{
+	_threadsCount = Max(threadsCount, 1);
+	if (_batchSize < _threadsCount)
+	{
+		_batchSize = _threadsCount * 16;
+	}
+}
+
+//Действует на пул, который создается при первой пачке
+void FileOperations::SetThreadPinning(ThreadPinning pinning)
+{
+	_pinning = pinning;
+}
+
+//Часть задания нумерует строки в сообщениях об ошибках так же, как весь файл
+void FileOperations::SetLineOffset(long long lineOffset)
+{
+	_lineOffset = lineOffset;
+}
+
+void FileOperations::SetBatchSize(int batchSize)
+{
+	_batchSize = Max(batchSize, 1);
+}
+
+//Пачке нужно хотя бы по несколько SmallRowBatch на поток, иначе строк одной операции не наберется
+void FileOperations::EnableRowBatches()
+{
+	_rowBatches = true;
+	_batchSize = Max(_batchSize, SmallRowBatch::lanesCount * _threadsCount * 4);
+}
+
+void FileOperations::EnableStatistics()
+{
+	delete _statistics;
+	_statistics = new Statistics();
+	ResetKernelCounters();
+}
+
+Statistics* FileOperations::GetStatistics()
+{
+	return _statistics;
+}
+
+//Без печати счетчики кэшей после задания забирает вызывающий через AddCacheCounters (процессы кусков)
+void FileOperations::SetCacheCountersPrinting(bool printing)
+{
+	_cacheCountersPrinting = printing;
+}
+
+int FileOperations::ReadChar(FILE* inputFile)
+{
+	_bytesRead++;
+	return fgetc(inputFile);
+}
 
 BigInt* FileOperations::ReadBigInt(FILE* inputFile, int ch)
 {
-	//  
-	//int ch = fgetc(inputFile);
+	char stringOfDigits[BigInt::maxDecDigitsCount];
+	int stringLength = ReadLine(inputFile, ch, stringOfDigits);
+
+	return ParseBigInt(stringOfDigits, stringLength);
+}
+
+//Читает строку до перевода строки в буфер из maxDecDigitsCount символов
+int FileOperations::ReadLine(FILE* inputFile, int ch, char* line)
+{
+	//Убираем ведущие нули
+	while (ch == '0')
+	{
+		ch = ReadChar(inputFile);
+	}
+
+	int length = 0;
+	while (ch != '\n' && ch != '\r' && ch != EOF)
+	{
+		if (length == BigInt::maxDecDigitsCount)
+		{
+			throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+		}
+
+		line[length] = ch;
+		length++;
+		ch = ReadChar(inputFile);
+	}
+
+	return length;
+}
+
+//Проверка по 8 символов: у цифры старшая половина байта 3, а младшая после прибавления 6 не переполняется
+static bool IsDecimal(const char* text, int length)
+{
+	const unsigned long long high = 0xF0F0F0F0F0F0F0F0ULL;
+	const unsigned long long zeros = 0x3030303030303030ULL;
+	const unsigned long long sixes = 0x0606060606060606ULL;
+
+	int i = 0;
+	for (; i + 8 <= length; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, text + i, sizeof(word));
+		if ((word & high) != zeros || ((word + sixes) & high) != zeros)
+		{
+			return false;
+		}
+	}
+
+	for (; i < length; i++)
+	{
+		if (text[i] < '0' || text[i] > '9')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//Проверенная десятичная запись в "цифры" младшими вперед, по baseDimentions символов с конца
+static int ParseDecimalLimbs(const char* text, int length, int* digits)
+{
+	int count = 0;
+	for (int end = length; end > 0; end -= BigInt::baseDimentions)
+	{
+		int digit = 0;
+		for (int i = Max(end - BigInt::baseDimentions, 0); i < end; i++)
+		{
+			digit = digit * 10 + (text[i] - '0');
+		}
+
+		digits[count] = digit;
+		count++;
+	}
+
+	return count;
+}
+
+BigInt* FileOperations::ParseBigInt(const char* stringOfDigits, int stringLength)
+{
+	//Убираем ведущие нули
+	while (stringLength > 0 && *stringOfDigits == '0')
+	{
+		stringOfDigits++;
+		stringLength--;
+	}
+
+	//Шестнадцатеричная запись: "0x" (ведущий ноль уже отброшен)
+	if (stringLength > 0 && (*stringOfDigits == 'x' || *stringOfDigits == 'X'))
+	{
+		return ParseHexBigInt(stringOfDigits + 1, stringLength - 1);
+	}
+
+	if (stringLength > BigInt::maxDecDigitsCount || !IsDecimal(stringOfDigits, stringLength))
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	INSTRUMENT_KERNEL(KERNEL_PARSE, stringLength / BigInt::baseDimentions + 1);
+	BigInt* bigInt = new BigInt(0, stringLength / BigInt::baseDimentions + 1);
+
+	if (stringLength == 0)
+	{
+		bigInt->size = 1;
+		return bigInt;
+	}
+
+	bigInt->size = ParseDecimalLimbs(stringOfDigits, stringLength, bigInt->digits);
+	return bigInt;
+}
+
+static int GetHexValue(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+	{
+		return ch - '0';
+	}
+
+	if (ch >= 'a' && ch <= 'f')
+	{
+		return ch - 'a' + 10;
+	}
+
+	if (ch >= 'A' && ch <= 'F')
+	{
+		return ch - 'A' + 10;
+	}
+
+	throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+}
+
+//Основание не степень двойки, поэтому число набирается умножением на 16^7 и прибавлением следующих 7 цифр
+BigInt* FileOperations::ParseHexBigInt(const char* stringOfDigits, int stringLength)
+{
+	INSTRUMENT_KERNEL(KERNEL_PARSE, stringLength / BigInt::baseDimentions + 1);
+	const int chunkLength = 7;
+
+	//Умножение на 16^7 дописывает "цифры" по ходу и читает их нулями: log10(16) / 4 < 5 / 16
+	BigInt* bigInt = new BigInt(0, stringLength * 5 / 16 + 2);
+	bigInt->size = 1;
+	try
+	{
+		for (int start = 0; start < stringLength; start += chunkLength)
+		{
+			int length = Min(chunkLength, stringLength - start);
+			long long chunk = 0;
+			for (int i = 0; i < length; i++)
+			{
+				chunk = chunk * 16 + GetHexValue(stringOfDigits[start + i]);
+			}
+
+			long long multiplier = 1LL << (4 * length);
+			long long carry = chunk;
+			int i = 0;
+			for (; i < bigInt->size || carry > 0; i++)
+			{
+				if (i == BigInt::maxDigitsCount)
+				{
+					throw AppException(ErrorMessages::ERROR);
+				}
+
+				long long value = bigInt->digits[i] * multiplier + carry;
+				carry = value / BigInt::base;
+				bigInt->digits[i] = (int)(value - carry * BigInt::base);
+			}
+			bigInt->size = DeleteExtraZeros(i, bigInt);
+		}
+	}
+	catch(AppException ex)
+	{
+		delete bigInt;
+		throw;
+	}
+
+	return bigInt;
+}
+
+void FileOperations::PrintBigInt(BigInt* bigInt)
+{
+	if (_outputFormat == OUTPUT_HEX)
+	{
+		PrintHexBigInt(bigInt);
+		return;
+	}
+
+	if (_outputFormat == OUTPUT_BINARY)
+	{
+		WriteBinaryField('N');
+		WriteBinaryBigInt(_outputFile, bigInt);
+		return;
+	}
+
+	PrintLimbs(bigInt->digits, bigInt->size);
+}
+
+void FileOperations::PrintLimbs(const int* digits, int size)
+{
+	INSTRUMENT_KERNEL(KERNEL_PRINT, size);
+
+	//Число печатается кусками фиксированного размера со старших "цифр",
+	//так что память не растет с длиной результата
+	char chunk[outputChunkLength];
+	int length = sprintf(chunk, "%d", digits[size - 1]);
+	for (int i = size - 2; i >= 0; i--)
+	{
+		FlushChunk(chunk, &length, BigInt::baseDimentions);
+
+		int digit = digits[i];
+		for (int j = BigInt::baseDimentions - 1; j >= 0; j--)
+		{
+			chunk[length + j] = (char)('0' + digit % 10);
+			digit /= 10;
+		}
+		length += BigInt::baseDimentions;
+	}
+
+	chunk[length] = '\n';
+	fwrite(chunk, 1, length + 1, _outputFile);
+}
+
+//Кусок уходит в файл, когда в нем не осталось места еще на reserve символов и перевод строки
+void FileOperations::FlushChunk(char* chunk, int* length, int reserve)
+{
+	if (*length + reserve + 1 > outputChunkLength)
+	{
+		fwrite(chunk, 1, *length, _outputFile);
+		*length = 0;
+	}
+}
+
+//Перевод из основания 10000 делением на 2^32: квадратичный, в отличие от десятичной печати
+void FileOperations::PrintHexBigInt(const BigInt* bigInt)
+{
+	INSTRUMENT_KERNEL(KERNEL_PRINT, bigInt->size);
+	int* digits = (int*) malloc(bigInt->size * sizeof(int));
+	unsigned int* words = (unsigned int*) malloc((bigInt->size / 2 + 1) * sizeof(unsigned int));
+	if (digits == NULL || words == NULL)
+	{
+		free(digits);
+		free(words);
+		throw AppException(ErrorMessages::MEMORY_ERROR);
+	}
+
+	memcpy(digits, bigInt->digits, bigInt->size * sizeof(int));
+	int size = bigInt->size;
+	int wordsCount = 0;
+	do
+	{
+		long long remainder = 0;
+		for (int i = size - 1; i >= 0; i--)
+		{
+			long long value = remainder * BigInt::base + digits[i];
+			digits[i] = (int)(value >> 32);
+			remainder = value & 0xFFFFFFFFLL;
+		}
+		words[wordsCount] = (unsigned int)remainder;
+		wordsCount++;
+
+		while (size > 0 && digits[size - 1] == 0)
+		{
+			size--;
+		}
+	}
+	while (size > 0);
+
+	char chunk[outputChunkLength];
+	int length = sprintf(chunk, "0x%x", words[wordsCount - 1]);
+	for (int i = wordsCount - 2; i >= 0; i--)
+	{
+		FlushChunk(chunk, &length, 8);
+		length += sprintf(chunk + length, "%08x", words[i]);
+	}
+
+	chunk[length] = '\n';
+	fwrite(chunk, 1, length + 1, _outputFile);
+
+	free(digits);
+	free(words);
+}
+
+void FileOperations::PrintError(const char* message) 
+{
+	if (_outputFormat == OUTPUT_BINARY)
+	{
+		unsigned int length = (unsigned int)strlen(message);
+		WriteBinaryField('E');
+		WriteBinaryField(length);
+		fwrite(message, 1, length, _outputFile);
+		return;
+	}
+
+	fprintf(_outputFile, "%s\n", message);
+}
+
+void FileOperations::WriteBinaryField(unsigned int value)
+{
+	fwrite(&value, sizeof(value), 1, _outputFile);
+}
+
+void FileOperations::ReadFromFile(FILE* inputFile)
+{
+	if (inputFile == NULL)
+	{
+		PrintError(ErrorMessages::FILE_OPEN_ERROR);
+		return;
+	}
+
+	//Текстовое задание начинается с цифры, двоичное - с сигнатуры
+	int ch = fgetc(inputFile);
+	ungetc(ch, inputFile);
+	ReadRows(inputFile, ch == binaryJobMagic[0]);
+}
+
+//Часть текстового задания может начинаться с любой строки, поэтому формат не определяется по первому байту
+void FileOperations::ReadTextFromFile(FILE* inputFile)
+{
+	if (inputFile == NULL)
+	{
+		PrintError(ErrorMessages::FILE_OPEN_ERROR);
+		return;
+	}
+
+	ReadRows(inputFile, false);
+}
+
+void FileOperations::ReadRows(FILE* inputFile, bool binary)
+{
+	long long started = GetNanoseconds();
+	_bytesRead = 0;
+	if (binary && !ReadBinaryHeader(inputFile))
+	{
+		PrintError(ErrorMessages::WRONG_INPUT_ERROR);
+		return;
+	}
+	_scanner.Reset(inputFile);
+	_binaryInput = binary;
+	long long binaryRows = 0;
+
+	//Строки читаются пачками: пачка считается в рабочих потоках и печатается по порядку
+	Row* rows = new Row[_batchSize];
+	const char* error = NULL;
+	bool finished = false;
+	while (!finished)
+	{
+		long long parseStarted = GetNanoseconds();
+		_scanner.ClearText();
+		_operands.Clear();
+		_operandLimbs.Clear();
+		int count = 0;
+		while (count < _batchSize)
+		{
+			try
+			{
+				bool read = binary ? ReadBinaryRow(inputFile, rows + count) : ScanTextRow(rows + count);
+				if (!read)
+				{
+					finished = true;
+					break;
+				}
+
+				if (binary)
+				{
+					binaryRows++;
+					rows[count].line = _lineOffset + binaryRows;
+				}
+			}
+			catch(AppException ex)
+			{
+				error = ex.GetMessage();
+				finished = true;
+				break;
+			}
+			count++;
+		}
+
+		long long computeStarted = GetNanoseconds();
+		ExecuteRows(rows, count);
+		long long printStarted = GetNanoseconds();
+		PrintRows(rows, count);
+
+		if (_statistics != NULL)
+		{
+			_statistics->AddPhase(PHASE_PARSE, computeStarted - parseStarted);
+			_statistics->AddPhase(PHASE_COMPUTE, printStarted - computeStarted);
+			_statistics->AddPhase(PHASE_PRINT, GetNanoseconds() - printStarted);
+		}
+	}
+	delete[] rows;
+
+	if (error != NULL)
+	{
+		PrintError(error);
+	}
+
+	if (_statistics != NULL)
+	{
+		_statistics->SetBytes(binary ? _bytesRead : _scanner.GetBytesRead());
+		_statistics->SetElapsed(GetNanoseconds() - started);
+	}
+
+	PrintStatistics();
+}
+
+static bool IsOperationLine(const char* line, int length)
+{
+	return length == 1 && (line[0] < '0' || line[0] > '9');
+}
+
+//Граница строк задания - после строки операции: ею заканчивается любая строка задания, в том числе неверная.
+//Ищется с первой строки, начинающейся не раньше position; без строки операции до конца - конец текста
+long long FileOperations::FindRowBoundary(const char* text, long long length, long long position)
+{
+	if (position == 0)
+	{
+		return 0;
+	}
+
+	const char* end = text + length;
+	const char* line = (const char*) memchr(text + position - 1, '\n', length - position + 1);
+	while (line != NULL && line + 1 < end)
+	{
+		line++;
+		const char* lineEnd = (const char*) memchr(line, '\n', end - line);
+		if (lineEnd == NULL)
+		{
+			break;
+		}
+
+		long long lineLength = lineEnd - line;
+		if (lineLength > 0 && line[lineLength - 1] == '\r')
+		{
+			lineLength--;
+		}
+
+		if (lineLength == 1 && IsOperationLine(line, 1))
+		{
+			return lineEnd + 1 - text;
+		}
+		line = lineEnd;
+	}
+
+	return length;
+}
+
+static bool IsReduction(int operation)
+{
+	return operation == '+' || operation == '*';
+}
+
+void FileOperations::AddOperand(int offset, int length)
+{
+	RowOperand operand;
+	operand.offset = offset;
+	operand.length = length;
+	_operands.Add(operand);
+}
+
+//Строка задания - строки операндов до строки операции. Больше двух операндов бывает только у + и * (свертка),
+//иначе строка задания отмечается ошибкой, а следующая начинается после ее строки операции
+bool FileOperations::ScanTextRow(Row* row)
+{
+	row->first = NULL;
+	row->second = NULL;
+	row->error = NULL;
+	row->executed = false;
+	row->smallSize = 0;
+	row->operandsCount = 0;
+	row->operandsIndex = 0;
+	row->line = _lineOffset + _scanner.GetLineNumber() + 1;
+
+	int operandsCount = 0;
+	bool empty = true;
+	bool tooLong = false;
+	while (true)
+	{
+		int offset;
+		int length;
+		if (!_scanner.ScanLine(&offset, &length, BigInt::maxDecDigitsCount + 1))
+		{
+			//Пустые строки в конце файла - не строка задания
+			if (empty)
+			{
+				return false;
+			}
+
+			row->operation = 0;
+			row->error = ErrorMessages::WRONG_INPUT_ERROR;
+			return true;
+		}
+
+		const char* line = _scanner.GetText() + offset;
+		if (IsOperationLine(line, length))
+		{
+			row->operation = line[0];
+			break;
+		}
+
+		if (operandsCount == 0)
+		{
+			row->firstOffset = offset;
+			row->firstLength = length;
+		}
+		else if (operandsCount == 1)
+		{
+			row->secondOffset = offset;
+			row->secondLength = length;
+		}
+		else
+		{
+			//С третьего операнда все операнды строки переписываются в список пачки
+			if (operandsCount == 2)
+			{
+				row->operandsIndex = _operands.GetCount();
+				AddOperand(row->firstOffset, row->firstLength);
+				AddOperand(row->secondOffset, row->secondLength);
+			}
+			AddOperand(offset, length);
+		}
+		operandsCount++;
+		empty = empty && length == 0;
+		tooLong = tooLong || length > BigInt::maxDecDigitsCount;
+	}
+
+	row->operandsCount = operandsCount;
+	if (operandsCount < 2 || (operandsCount > 2 && !IsReduction(row->operation)) || tooLong)
+	{
+		row->error = ErrorMessages::WRONG_INPUT_ERROR;
+	}
+
+	return true;
+}
+
+static void SkipZeros(const char** text, int* length)
+{
+	while (*length > 0 && **text == '0')
+	{
+		(*text)++;
+		(*length)--;
+	}
+}
+
+static bool IsHex(const char* text, int length)
+{
+	return length > 0 && (text[0] == 'x' || text[0] == 'X');
+}
+
+//Десятичные записи без ведущих нулей сравниваются по длине, а при равной длине - memcmp
+static int CompareText(const char* left, int leftLength, const char* right, int rightLength)
+{
+	if (leftLength != rightLength)
+	{
+		return leftLength - rightLength;
+	}
+
+	return memcmp(left, right, leftLength);
+}
+
+//По тексту решаются сравнения, умножение на ноль, вычитание большего и деление на большее
+static bool DecideByText(Row* row, const char* text)
+{
+	const char* first = text + row->firstOffset;
+	int firstLength = row->firstLength;
+	const char* second = text + row->secondOffset;
+	int secondLength = row->secondLength;
+	SkipZeros(&first, &firstLength);
+	SkipZeros(&second, &secondLength);
+	if (IsHex(first, firstLength) || IsHex(second, secondLength))
+	{
+		return false;
+	}
+
+	if (!IsDecimal(first, firstLength) || !IsDecimal(second, secondLength))
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	switch(row->operation)
+	{
+	case '<':
+		row->condition = CompareText(first, firstLength, second, secondLength) < 0;
+		return true;
+	case '>':
+		row->condition = CompareText(first, firstLength, second, secondLength) > 0;
+		return true;
+	case '=':
+		row->condition = CompareText(first, firstLength, second, secondLength) == 0;
+		return true;
+	case '*':
+		if (firstLength == 0 || secondLength == 0)
+		{
+			row->digit = new BigInt(0);
+			return true;
+		}
+		return false;
+	case '-':
+		if (CompareText(first, firstLength, second, secondLength) < 0)
+		{
+			throw AppException(ErrorMessages::ERROR);
+		}
+		return false;
+	case '/':
+		if (secondLength > 0 && CompareText(first, firstLength, second, secondLength) < 0)
+		{
+			row->digit = new BigInt(0);
+			return true;
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+template <int Limbs>
+static void ParseFixed(const char* text, int length, FixedBigInt<Limbs>* digit)
+{
+	memset(digit->digits, 0, sizeof(digit->digits));
+	ParseDecimalLimbs(text, length, digit->digits);
+}
+
+template <int Limbs>
+static void ExecuteFixedRow(Row* row, const char* first, int firstLength, const char* second, int secondLength)
+{
+	INSTRUMENT_KERNEL(KERNEL_FIXED, Limbs);
+	FixedBigInt<Limbs> left;
+	FixedBigInt<Limbs> right;
+	ParseFixed(first, firstLength, &left);
+	ParseFixed(second, secondLength, &right);
+
+	if (row->operation == '*')
+	{
+		FixedBigInt<2 * Limbs> product;
+		Multiply(&left, &right, &product);
+		row->digit = ToBigInt(&product);
+		return;
+	}
+
+	FixedBigInt<Limbs> result;
+	if (row->operation == '+')
+	{
+		Add(&left, &right, &result);
+	}
+	else if (!Subtract(&left, &right, &result))
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	row->digit = ToBigInt(&result);
+}
+
+//Сложение, вычитание и умножение операндов до ~1024 бит идут в FixedBigInt наименьшей подходящей ширины:
+//операнды не выделяются, а циклы не зависят от size. Строка уже проверена DecideByText
+static bool ExecuteFixed(Row* row, const char* text)
+{
+	if (row->operation != '+' && row->operation != '-' && row->operation != '*')
+	{
+		return false;
+	}
+
+	const char* first = text + row->firstOffset;
+	int firstLength = row->firstLength;
+	const char* second = text + row->secondOffset;
+	int secondLength = row->secondLength;
+	SkipZeros(&first, &firstLength);
+	SkipZeros(&second, &secondLength);
+	if (IsHex(first, firstLength) || IsHex(second, secondLength))
+	{
+		return false;
+	}
+
+	//Сумме нужна лишняя "цифра" на перенос
+	int limbs = (Max(firstLength, secondLength) + BigInt::baseDimentions - 1) / BigInt::baseDimentions + (row->operation == '+' ? 1 : 0);
+	if (limbs <= 10)
+	{
+		ExecuteFixedRow<10>(row, first, firstLength, second, secondLength);
+	}
+	else if (limbs <= 20)
+	{
+		ExecuteFixedRow<20>(row, first, firstLength, second, secondLength);
+	}
+	else if (limbs <= 40)
+	{
+		ExecuteFixedRow<40>(row, first, firstLength, second, secondLength);
+	}
+	else if (limbs <= 80)
+	{
+		ExecuteFixedRow<80>(row, first, firstLength, second, secondLength);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool FileOperations::ReadBinaryHeader(FILE* inputFile)
+{
+	BinaryJobHeader header;
+	size_t read = fread(&header, 1, sizeof(header), inputFile);
+	_bytesRead += read;
+
+	return read == sizeof(header) && memcmp(header.magic, binaryJobMagic, sizeof(binaryJobMagic)) == 0
+		&& header.version >= 1 && header.version <= binaryJobVersion && header.base == (unsigned int)BigInt::base;
+}
+
+//Код ошибки в строке двоичного задания: 0 - неверный формат, 1 - ошибка вычисления, 2 - нехватка памяти
+static unsigned int GetBinaryErrorCode(const char* error)
+{
+	if (error == ErrorMessages::ERROR)
+	{
+		return 1;
+	}
+
+	return error == ErrorMessages::MEMORY_ERROR ? 2 : 0;
+}
+
+static const char* GetBinaryError(unsigned int code)
+{
+	if (code == 1)
+	{
+		return ErrorMessages::ERROR;
+	}
+
+	return code == 2 ? ErrorMessages::MEMORY_ERROR : ErrorMessages::WRONG_INPUT_ERROR;
+}
+
+static void WriteBinaryErrorRow(FILE* outputFile, unsigned int operation, const char* error)
+{
+	unsigned int fields[] = {operation, 0, GetBinaryErrorCode(error)};
+	fwrite(fields, sizeof(fields), 1, outputFile);
+}
+
+unsigned int FileOperations::ReadBinaryField(FILE* inputFile)
+{
+	unsigned int value;
+	if (fread(&value, sizeof(value), 1, inputFile) != 1)
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+	_bytesRead += sizeof(value);
+
+	return value;
+}
+
+bool FileOperations::ReadBinaryRow(FILE* inputFile, Row* row)
+{
+	unsigned int operation;
+	if (fread(&operation, sizeof(operation), 1, inputFile) != 1)
+	{
+		return false;
+	}
+	_bytesRead += sizeof(operation);
+
+	//У унарных операций второй операнд можно не записывать
+	unsigned int operandsCount = ReadBinaryField(inputFile);
+	if (operandsCount > 0x7FFFFFFF)
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	row->operation = (int)operation;
+	row->error = NULL;
+	row->executed = false;
+	row->smallSize = 0;
+	row->operandsCount = 2;
+	row->operandsIndex = 0;
+	row->first = NULL;
+	row->second = NULL;
+	if (operandsCount == 0)
+	{
+		row->error = GetBinaryError(ReadBinaryField(inputFile));
+		return true;
+	}
+
+	if (operandsCount > 2)
+	{
+		ReadBinaryReduction(inputFile, row, operandsCount);
+		return true;
+	}
+
+	row->first = ReadBinaryBigInt(inputFile);
+	try
+	{
+		row->second = operandsCount == 2 ? ReadBinaryBigInt(inputFile) : new BigInt(0);
+	}
+	catch(AppException ex)
+	{
+		delete row->first;
+		throw;
+	}
+
+	//Неверные "цифры" портят только свою строку: длины известны, и чтение не сбивается
+	if (row->first == NULL || row->second == NULL)
+	{
+		delete row->first;
+		delete row->second;
+		row->first = NULL;
+		row->second = NULL;
+		row->error = ErrorMessages::WRONG_INPUT_ERROR;
+	}
+
+	return true;
+}
+
+//"Цифры" операндов свертки копируются в общий список пачки: держать N чисел BigInt до выполнения слишком дорого
+void FileOperations::ReadBinaryReduction(FILE* inputFile, Row* row, unsigned int operandsCount)
+{
+	row->operandsCount = (int)operandsCount;
+	row->operandsIndex = _operands.GetCount();
+	bool valid = IsReduction(row->operation);
+	for (unsigned int i = 0; i < operandsCount; i++)
+	{
+		BigInt* digit = ReadBinaryBigInt(inputFile);
+		if (digit == NULL)
+		{
+			valid = false;
+			continue;
+		}
+
+		AddOperand(_operandLimbs.GetCount(), digit->size);
+		for (int limb = 0; limb < digit->size; limb++)
+		{
+			_operandLimbs.Add(digit->digits[limb]);
+		}
+		delete digit;
+	}
+
+	if (!valid)
+	{
+		row->error = ErrorMessages::WRONG_INPUT_ERROR;
+	}
+}
+
+BigInt* FileOperations::ReadBinaryBigInt(FILE* inputFile)
+{
+	unsigned int limbsCount = ReadBinaryField(inputFile);
+	if (limbsCount > (unsigned int)BigInt::maxDigitsCount)
+	{
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	//"Цифры" читаются прямо в число, без разбора текста
+	BigInt* bigInt = new BigInt(0, limbsCount);
+	size_t read = fread(bigInt->digits, sizeof(int), limbsCount, inputFile);
+	_bytesRead += read * sizeof(int);
+
+	if (read != limbsCount)
+	{
+		delete bigInt;
+		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
+	}
+
+	for (unsigned int i = 0; i < limbsCount; i++)
+	{
+		if (bigInt->digits[i] < 0 || bigInt->digits[i] >= BigInt::base)
+		{
+			delete bigInt;
+			return NULL;
+		}
+	}
+
+	bigInt->size = limbsCount > 0 ? DeleteExtraZeros(limbsCount, bigInt) : 1;
+	return bigInt;
+}
+
+void FileOperations::WriteBinaryBigInt(FILE* outputFile, const BigInt* bigInt)
+{
+	unsigned int limbsCount = bigInt->size;
+	fwrite(&limbsCount, sizeof(limbsCount), 1, outputFile);
+	fwrite(bigInt->digits, sizeof(int), limbsCount, outputFile);
+}
+
+void FileOperations::ConvertToBinary(FILE* inputFile, FILE* outputFile)
+{
+	if (inputFile == NULL || outputFile == NULL)
+	{
+		PrintError(ErrorMessages::FILE_OPEN_ERROR);
+		return;
+	}
+
+	BinaryJobHeader header;
+	memcpy(header.magic, binaryJobMagic, sizeof(binaryJobMagic));
+	header.version = binaryJobVersion;
+	header.base = BigInt::base;
+	header.reserved = 0;
+	fwrite(&header, sizeof(header), 1, outputFile);
+
+	_scanner.Reset(inputFile);
+	Row row;
+	while (ScanTextRow(&row))
+	{
+		if (row.operandsCount > 2 && row.error == NULL)
+		{
+			ConvertReductionToBinary(&row, outputFile);
+			_scanner.ClearText();
+			_operands.Clear();
+			continue;
+		}
+
+		BigInt* first = NULL;
+		BigInt* second = NULL;
+		const char* error = row.error;
+		try
+		{
+			if (error == NULL)
+			{
+				first = ParseBigInt(_scanner.GetText() + row.firstOffset, row.firstLength);
+				second = ParseBigInt(_scanner.GetText() + row.secondOffset, row.secondLength);
+			}
+		}
+		catch(AppException ex)
+		{
+			error = ex.GetMessage();
+		}
+
+		//Неверная строка записывается строкой-ошибкой, чтобы результаты не сдвигались
+		if (error != NULL)
+		{
+			WriteBinaryErrorRow(outputFile, row.operation, error);
+		}
+		else
+		{
+			unsigned int operation = row.operation;
+			unsigned int operandsCount = 2;
+			fwrite(&operation, sizeof(operation), 1, outputFile);
+			fwrite(&operandsCount, sizeof(operandsCount), 1, outputFile);
+			WriteBinaryBigInt(outputFile, first);
+			WriteBinaryBigInt(outputFile, second);
+		}
+
+		delete first;
+		delete second;
+		_scanner.ClearText();
+		_operands.Clear();
+	}
+}
+
+//Строка-свертка пишется с настоящим числом операндов; неверная - строкой-ошибкой
+void FileOperations::ConvertReductionToBinary(const Row* row, FILE* outputFile)
+{
+	BigInt** operands = new BigInt*[row->operandsCount];
+	int parsedCount = 0;
+	try
+	{
+		for (; parsedCount < row->operandsCount; parsedCount++)
+		{
+			const RowOperand* operand = _operands.GetElements() + row->operandsIndex + parsedCount;
+			operands[parsedCount] = ParseBigInt(_scanner.GetText() + operand->offset, operand->length);
+		}
+	}
+	catch(AppException ex)
+	{
+		WriteBinaryErrorRow(outputFile, row->operation, ex.GetMessage());
+	}
 
-	while (ch == '0')
+	if (parsedCount == row->operandsCount)
 	{
-		ch = fgetc(inputFile);
+		unsigned int operation = row->operation;
+		unsigned int operandsCount = row->operandsCount;
+		fwrite(&operation, sizeof(operation), 1, outputFile);
+		fwrite(&operandsCount, sizeof(operandsCount), 1, outputFile);
+		for (unsigned int i = 0; i < operandsCount; i++)
+		{
+			WriteBinaryBigInt(outputFile, operands[i]);
+		}
 	}
 
-	BigInt* bigInt = new BigInt();
+	for (int i = 0; i < parsedCount; i++)
+	{
+		delete operands[i];
+	}
+	delete[] operands;
+}
 
-	if (ch == '\n' || ch == '\r')
+void FileOperations::ExecuteRows(Row* rows, int count)
+{
+	//У каждого потока свой исполнитель: кэши и подготовленные делители не делятся между потоками,
+	//а заданный размер кэша делится между ними поровну
+	if (_threadsCount > 1 && _pool == NULL)
 	{
-		bigInt->size = 1;
-		return bigInt;
+		_pool = new ThreadPool(_threadsCount, _pinning);
+		_executors = new FileOperations[_threadsCount];
+		for (int i = 0; i < _threadsCount; i++)
+		{
+			if (_cache != NULL)
+			{
+				_executors[i].EnableCache(_cacheBytes / _threadsCount);
+			}
+
+			if (_powerCache != NULL)
+			{
+				_executors[i].EnablePowerCache(_powerCacheBytes / _threadsCount);
+			}
+		}
 	}
 
-	char stringOfDigits[BigInt::maxDecDigitsCount];
-	int stringLength = 0;
-	while (ch != '\n'&& ch != '\r')
+	const char* text = _scanner.GetText();
+	if (_rowBatches)
 	{
-		stringOfDigits[stringLength] = ch;
-		stringLength++;
-		ch = fgetc(inputFile);
+		int slicesCount = (count + SmallRowBatch::lanesCount - 1) / SmallRowBatch::lanesCount;
+		if (_pool == NULL)
+		{
+			for (int i = 0; i < slicesCount; i++)
+			{
+				int start = i * SmallRowBatch::lanesCount;
+				ExecuteSmallRows(this, rows + start, Min(count - start, SmallRowBatch::lanesCount), text);
+			}
+		}
+		else
+		{
+			void* context[] = {this, rows, &count};
+			_pool->Run(slicesCount, ExecuteSmallRowsTask, context);
+		}
 	}
 
-	int digitLength = BigInt::baseDimentions;
+	if (_pool == NULL)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			ExecuteRow(this, rows + i, text);
+		}
+	}
+	else
+	{
+		void* context[] = {this, rows};
+		_pool->Run(count, ExecuteRowTask, context);
+	}
 
-	int digitPosition = 0;
-	//   
-	for(int i = stringLength - 1; i >= 0; i -= digitLength)
+	//Строки-свертки идут по одной, но каждую делят между собой все потоки
+	for (int i = 0; i < count; i++)
 	{
-		//    
-		int startOfDigit = i - digitLength + 1;
-		//    ,    
-		if (startOfDigit < 0)
+		if (rows[i].operandsCount > 2 && rows[i].error == NULL)
 		{
-			digitLength += startOfDigit;
-			startOfDigit = 0;
+			ExecuteReduction(rows + i, text);
 		}
+	}
+}
+
+void FileOperations::ExecuteRowTask(int index, int worker, void* context)
+{
+	FileOperations* operations = (FileOperations*) ((void**) context)[0];
+	Row* rows = (Row*) ((void**) context)[1];
+	ExecuteRow(operations->_executors + worker, rows + index, operations->_scanner.GetText());
+}
+
+//Операнды текстовых строк переводятся в "цифры" здесь, в рабочем потоке, и только если операция без них не решается
+void FileOperations::ExecuteRow(FileOperations* executor, Row* row, const char* text)
+{
+	//Строка, посчитанная в SmallRowBatch, уже готова
+	if (row->executed)
+	{
+		return;
+	}
+
+	//Строка, отмеченная ошибкой при чтении, не выполняется
+	if (row->error != NULL)
+	{
+		row->nanoseconds = 0;
+		return;
+	}
+
+	//Свертку считает ExecuteReduction
+	if (row->operandsCount > 2)
+	{
+		return;
+	}
 
-		// 
-		char digitString[BigInt::baseDimentions];
-		for(int j = 0; j < digitLength; j++)
+	long long started = GetNanoseconds();
+	row->condition = false;
+	row->digit = NULL;
+	try
+	{
+		bool decided = row->first == NULL && (DecideByText(row, text) || ExecuteFixed(row, text));
+		if (!decided)
 		{
-			digitString[j] = stringOfDigits[startOfDigit + j];
+			if (row->first == NULL)
+			{
+				row->first = executor->ParseBigInt(text + row->firstOffset, row->firstLength);
+				row->second = executor->ParseBigInt(text + row->secondOffset, row->secondLength);
+			}
+
+			Result result = executor->ExecuteOperation(row->operation, row->first, row->second);
+			row->condition = result.condition;
+			row->digit = result.digit;
+			result.digit = NULL;
 		}
-		// ,      
-		if (digitLength < BigInt::baseDimentions)
+	}
+	catch(AppException ex)
+	{
+		row->error = ex.GetMessage();
+	}
+	row->nanoseconds = GetNanoseconds() - started;
+
+	delete row->first;
+	delete row->second;
+	row->first = NULL;
+	row->second = NULL;
+}
+
+// Часть операндов строки-свертки, которую сворачивает один поток
+struct ReductionPart
+{
+	const RowOperand* operands;
+	int count;
+	int operation;
+	BigInt* result;
+	const char* error;
+	bool overflow;
+};
+
+//Операнд свертки: из текста пачки или из "цифр" двоичного задания
+static BigInt* GetReductionOperand(FileOperations* executor, const RowOperand* operand, const char* text, const int* limbs)
+{
+	if (limbs == NULL)
+	{
+		return executor->ParseBigInt(text + operand->offset, operand->length);
+	}
+
+	BigInt* digit = new BigInt(0, operand->length);
+	memcpy(digit->digits, limbs + operand->offset, operand->length * sizeof(int));
+	digit->size = operand->length;
+	return digit;
+}
+
+//Операнды переводятся в числа по одному и сразу уходят в свертку
+static void ReducePart(FileOperations* executor, ReductionPart* part, const char* text, const int* limbs)
+{
+	part->result = NULL;
+	part->error = NULL;
+	part->overflow = false;
+	try
+	{
+		Reduction reduction(part->operation);
+		for (int i = 0; i < part->count; i++)
 		{
-			digitString[digitLength] = '\0';
+			reduction.Add(GetReductionOperand(executor, part->operands + i, text, limbs));
 		}
 
-		bigInt->digits[digitPosition] = atoi(digitString);
-		digitPosition++;
+		//Все операнды разобраны: ошибка здесь - переполнение, которое ноль другой части еще может отменить
+		part->overflow = true;
+		part->result = reduction.GetResult();
+		part->overflow = false;
+	}
+	catch(AppException ex)
+	{
+		part->error = ex.GetMessage();
+		part->overflow = part->overflow && part->error == ErrorMessages::ERROR;
 	}
+}
 
-	bigInt->size = digitPosition;
-	return bigInt;
+void FileOperations::ExecuteReductionTask(int index, int worker, void* context)
+{
+	FileOperations* operations = (FileOperations*) ((void**) context)[0];
+	ReductionPart* parts = (ReductionPart*) ((void**) context)[1];
+	const char* text = (const char*) ((void**) context)[2];
+	const int* limbs = (const int*) ((void**) context)[3];
+	ReducePart(operations->_executors + worker, parts + index, text, limbs);
 }
 
-void FileOperations::PrintBigInt(BigInt* bigInt)
+//Операнды делятся на части по числу потоков подряд: каждая часть - свое поддерево,
+//частичные результаты сворачиваются той же операцией в конце
+void FileOperations::ExecuteReduction(Row* row, const char* text)
 {
-	const char format[] = "%.4d";
+	long long started = GetNanoseconds();
+	row->condition = false;
+	row->digit = NULL;
+
+	int partsCount = _pool != NULL ? Min(_threadsCount, row->operandsCount) : 1;
+	const RowOperand* operands = _operands.GetElements() + row->operandsIndex;
+	const int* limbs = _binaryInput ? _operandLimbs.GetElements() : NULL;
+	ReductionPart* parts = new ReductionPart[partsCount];
+	for (int i = 0; i < partsCount; i++)
+	{
+		int start = (int)((long long)row->operandsCount * i / partsCount);
+		int end = (int)((long long)row->operandsCount * (i + 1) / partsCount);
+		parts[i].operands = operands + start;
+		parts[i].count = end - start;
+		parts[i].operation = row->operation;
+	}
+
+	if (_pool == NULL)
+	{
+		ReducePart(this, parts, text, limbs);
+	}
+	else
+	{
+		void* context[] = {this, parts, (void*)text, (void*)limbs};
+		_pool->Run(partsCount, ExecuteReductionTask, context);
+	}
 
-	printf("%d",bigInt->digits[bigInt->size-1]);
-	for (int i = bigInt->size - 2; i >= 0; i--)
+	//Ошибка разбора - ошибка строки; переполнение части - только если ни в одной части нет нулевого множителя
+	bool zero = false;
+	for (int i = 0; i < partsCount; i++)
 	{
-		printf(format, bigInt->digits[i]);
+		zero = zero || (row->operation == '*' && parts[i].result != NULL && IsZero(parts[i].result));
+		if (row->error == NULL && parts[i].error != NULL && !parts[i].overflow)
+		{
+			row->error = parts[i].error;
+		}
+	}
+
+	for (int i = 0; i < partsCount && row->error == NULL && !zero; i++)
+	{
+		row->error = parts[i].error;
+	}
+
+	if (partsCount == 1)
+	{
+		row->digit = parts[0].result;
+	}
+	else
+	{
+		try
+		{
+			Reduction reduction(row->operation);
+			for (int i = 0; i < partsCount; i++)
+			{
+				BigInt* result = parts[i].result;
+				parts[i].result = NULL;
+				if (row->error == NULL && result != NULL)
+				{
+					reduction.Add(result);
+				}
+				else
+				{
+					delete result;
+				}
+			}
+
+			if (row->error == NULL)
+			{
+				row->digit = reduction.GetResult();
+			}
+		}
+		catch(AppException ex)
+		{
+			row->error = ex.GetMessage();
+		}
+	}
+
+	if (row->error != NULL)
+	{
+		delete row->digit;
+		row->digit = NULL;
 	}
-	printf("\n");
+
+	delete[] parts;
+	row->nanoseconds = GetNanoseconds() - started;
 }
 
-void FileOperations::PrintError(const char* message) 
+void FileOperations::ExecuteSmallRowsTask(int index, int worker, void* context)
 {
-	printf("%s\n", message);
+	FileOperations* operations = (FileOperations*) ((void**) context)[0];
+	Row* rows = (Row*) ((void**) context)[1];
+	int count = *(int*) ((void**) context)[2];
+	int start = index * SmallRowBatch::lanesCount;
+	ExecuteSmallRows(operations->_executors + worker, rows + start, Min(count - start, SmallRowBatch::lanesCount),
+		operations->_scanner.GetText());
 }
 
-void FileOperations::ReadFromFile(FILE* inputFile)
+static const char smallOperations[] = "+-*<>=";
+static const int smallOperationsCount = 6;
+
+//Операнд строки в "цифры" пачки: из текста, если он короткий и десятичный, или из двоичного задания
+static bool GetSmallOperand(const Row* row, bool first, const char* text, int* digits)
+{
+	memset(digits, 0, SmallRowBatch::limbsCount * sizeof(int));
+	const BigInt* operand = first ? row->first : row->second;
+	if (operand != NULL)
+	{
+		if (operand->size > SmallRowBatch::limbsCount)
+		{
+			return false;
+		}
+
+		memcpy(digits, operand->digits, operand->size * sizeof(int));
+		return true;
+	}
+
+	const char* digitsText = text + (first ? row->firstOffset : row->secondOffset);
+	int length = first ? row->firstLength : row->secondLength;
+	SkipZeros(&digitsText, &length);
+	if (length > SmallRowBatch::maxDecDigitsCount || IsHex(digitsText, length) || !IsDecimal(digitsText, length))
+	{
+		return false;
+	}
+
+	ParseDecimalLimbs(digitsText, length, digits);
+	return true;
+}
+
+//Короткие строки +, -, *, <, >, = собираются по операциям в SmallRowBatch и считаются сразу по всем строкам,
+//результаты раскладываются обратно по своим строкам. Остальные (длинные, неверные, другие операции)
+//не трогаются и выполняются ExecuteRow
+void FileOperations::ExecuteSmallRows(FileOperations* executor, Row* rows, int count, const char* text)
+{
+	if (executor->_smallRows == NULL)
+	{
+		executor->_smallRows = new SmallRowBatch();
+	}
+
+	SmallRowBatch* batch = executor->_smallRows;
+	for (int operationIndex = 0; operationIndex < smallOperationsCount; operationIndex++)
+	{
+		long long started = GetNanoseconds();
+		int operation = smallOperations[operationIndex];
+		int indices[SmallRowBatch::lanesCount];
+		batch->count = 0;
+		for (int i = 0; i < count; i++)
+		{
+			Row* row = rows + i;
+			if (row->executed || row->error != NULL || row->operation != operation || row->operandsCount > 2)
+			{
+				continue;
+			}
+
+			int left[SmallRowBatch::limbsCount];
+			int right[SmallRowBatch::limbsCount];
+			if (!GetSmallOperand(row, true, text, left) || !GetSmallOperand(row, false, text, right))
+			{
+				continue;
+			}
+
+			for (int limb = 0; limb < SmallRowBatch::limbsCount; limb++)
+			{
+				batch->left[limb][batch->count] = left[limb];
+				batch->right[limb][batch->count] = right[limb];
+			}
+			indices[batch->count] = i;
+			batch->count++;
+		}
+
+		if (batch->count == 0)
+		{
+			continue;
+		}
+
+		int resultLimbs = SmallRowBatch::limbsCount;
+		switch(operation)
+		{
+		case '+':
+			AddSmallRows(batch);
+			resultLimbs++;
+			break;
+		case '-':
+			SubtractSmallRows(batch);
+			break;
+		case '*':
+			MultiplySmallRows(batch);
+			resultLimbs *= 2;
+			break;
+		default:
+			CompareSmallRows(batch);
+			resultLimbs = 0;
+			break;
+		}
+
+		for (int lane = 0; lane < batch->count; lane++)
+		{
+			Row* row = rows + indices[lane];
+			row->executed = true;
+			row->condition = false;
+			row->digit = NULL;
+			delete row->first;
+			delete row->second;
+			row->first = NULL;
+			row->second = NULL;
+
+			if (resultLimbs == 0)
+			{
+				int sign = batch->result[0][lane];
+				row->condition = operation == '<' ? sign < 0 : operation == '>' ? sign > 0 : sign == 0;
+			}
+			else if (operation == '-' && batch->result[SmallRowBatch::limbsCount][lane] != 0)
+			{
+				row->error = ErrorMessages::ERROR;
+			}
+			else
+			{
+				//Короткий результат остается в строке: BigInt на каждую строку пачки стоил бы больше самой пачки
+				int size = resultLimbs;
+				while (size > 1 && batch->result[size - 1][lane] == 0)
+				{
+					size--;
+				}
+
+				for (int limb = 0; limb < size; limb++)
+				{
+					row->smallDigits[limb] = batch->result[limb][lane];
+				}
+				row->smallSize = size;
+			}
+		}
+
+		//Время пачки делится между ее строками поровну
+		long long nanoseconds = (GetNanoseconds() - started) / batch->count;
+		for (int lane = 0; lane < batch->count; lane++)
+		{
+			rows[indices[lane]].nanoseconds = nanoseconds;
+		}
+	}
+}
+
+void FileOperations::PrintRows(Row* rows, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		Row* row = rows + i;
+		if (row->error != NULL)
+		{
+			PrintError(row->error);
+			if (_errorFile != NULL)
+			{
+				fprintf(_errorFile, "%s %lld: %s\n", _binaryInput ? "Row" : "Line", row->line, row->error);
+			}
+		}
+		else if (row->smallSize > 0)
+		{
+			PrintSmallDigit(row);
+		}
+		else
+		{
+			Result result(row->condition, row->digit);
+			PrintResult(&result);
+		}
+
+		if (_statistics != NULL)
+		{
+			_statistics->AddRow(row->operation, row->nanoseconds);
+		}
+	}
+}
+
+//Результат из SmallRowBatch: десятичный печатается прямо из строки, для остальных форматов нужен BigInt
+void FileOperations::PrintSmallDigit(const Row* row)
+{
+	if (_outputFormat == OUTPUT_DECIMAL)
+	{
+		PrintLimbs(row->smallDigits, row->smallSize);
+		return;
+	}
+
+	BigInt* digit = new BigInt(0, row->smallSize);
+	memcpy(digit->digits, row->smallDigits, row->smallSize * sizeof(int));
+	digit->size = row->smallSize;
+	PrintBigInt(digit);
+	delete digit;
+}
+
+void FileOperations::ReadExpressionsFromFile(FILE* inputFile)
 {
 	if (inputFile == NULL)
 	{
 		PrintError(ErrorMessages::FILE_OPEN_ERROR);
 		return;
 	}
+
+	ExpressionEvaluator evaluator(this);
+	TList<char> line;
 	int ch = fgetc(inputFile);
-	while(!feof(inputFile) && ch != EOF)
+	while (ch != EOF)
 	{
-		BigInt* first = ReadBigInt(inputFile, ch);
-		BigInt* second = ReadBigInt(inputFile, fgetc(inputFile));
-		int operation = fgetc(inputFile);
-		fgetc(inputFile);
-		try
+		if (ch == '\n' || ch == '\r')
 		{
-			Result result = ExecuteOperation(operation, first, second);
-			PrintResult(&result);
-			delete first;
-			delete second;
+			evaluator.Execute(line.GetElements(), line.GetCount());
+			line.Clear();
 		}
-		catch(AppException ex)
+		else
 		{
-			PrintError(ex.GetMessage());
+			line.Add((char)ch);
 		}
+
 		ch = fgetc(inputFile);
 	}
+
+	evaluator.Execute(line.GetElements(), line.GetCount());
+
+	PrintStatistics();
 }
 
 Result FileOperations::ExecuteOperation(int operation, BigInt* first, BigInt* second)
 {
 	BigInt* digit = NULL;
 	bool condition = false;
+	unsigned int hash = _cache != NULL ? ResultCache::Hash(operation, first, second) : 0;
+	if (_cache != NULL && _cache->Find(hash, operation, first, second, &condition, &digit))
+	{
+		return Result(condition, digit);
+	}
+
 	switch(operation)
 	{
 	case '+':
@@ -131,12 +1651,42 @@ Result FileOperations::ExecuteOperation(int operation, BigInt* first, BigInt* se
 		}
 	case '/':
 		{
-			digit = Divide(first, second);
+			digit = GetPreparedDivisor(second)->Divide(first);
 			break;
 		}
 	case '^':
 		{
-			digit = Power(first, second);
+			digit = Power(first, second, _powerCache);
+			break;
+		}
+	case 'Q':
+		{
+			digit = SquareRoot(first);
+			break;
+		}
+	case 'R':
+		{
+			digit = Root(first, second);
+			break;
+		}
+	case 'G':
+		{
+			digit = Gcd(first, second);
+			break;
+		}
+	case '!':
+		{
+			digit = Factorial(first);
+			break;
+		}
+	case 'C':
+		{
+			digit = Binomial(first, second);
+			break;
+		}
+	case 'P':
+		{
+			digit = RangeProduct(first, second);
 			break;
 		}
 	case '>':
@@ -158,9 +1708,89 @@ Result FileOperations::ExecuteOperation(int operation, BigInt* first, BigInt* se
 		throw AppException(ErrorMessages::WRONG_INPUT_ERROR);
 	}
 
+	if (_cache != NULL)
+	{
+		_cache->Add(hash, operation, first, second, condition, digit);
+	}
+
 	return Result(condition, digit);
 }
 
+//Строки с одним делителем используют один раз подготовленный делитель
+const PreparedDivisor* FileOperations::GetPreparedDivisor(const BigInt* divisor)
+{
+	for (int i = _divisors.GetCount() - 1; i >= 0; i--)
+	{
+		if (_divisors[i]->IsFor(divisor))
+		{
+			return _divisors[i];
+		}
+	}
+
+	PreparedDivisor* prepared = new PreparedDivisor(divisor);
+	if (_divisors.GetCount() == preparedDivisorsCount)
+	{
+		PreparedDivisor* oldest = _divisors[0];
+		_divisors.Remove(oldest);
+		delete oldest;
+	}
+	_divisors.Add(prepared);
+
+	return prepared;
+}
+
+void FileOperations::PrintStatistics()
+{
+	if (!_cacheCountersPrinting)
+	{
+		return;
+	}
+
+	CacheCounters counters;
+	memset(&counters, 0, sizeof(counters));
+	AddCacheCounters(&counters);
+	PrintCacheCounters(&counters);
+}
+
+//При нескольких потоках счетчики кэшей складываются по исполнителям
+void FileOperations::AddCacheCounters(CacheCounters* counters)
+{
+	int executorsCount = _executors != NULL ? _threadsCount : 1;
+	FileOperations* executors = _executors != NULL ? _executors : this;
+	for (int i = 0; i < executorsCount; i++)
+	{
+		if (executors[i]._cache != NULL)
+		{
+			counters->hits += executors[i]._cache->GetHits();
+			counters->misses += executors[i]._cache->GetMisses();
+			counters->usedBytes += executors[i]._cache->GetUsedBytes();
+		}
+
+		if (executors[i]._powerCache != NULL)
+		{
+			counters->powerHits += executors[i]._powerCache->GetHits();
+			counters->powerReuses += executors[i]._powerCache->GetReuses();
+			counters->powerMisses += executors[i]._powerCache->GetMisses();
+			counters->powerUsedBytes += executors[i]._powerCache->GetUsedBytes();
+		}
+	}
+}
+
+void FileOperations::PrintCacheCounters(const CacheCounters* counters)
+{
+	if (_cache != NULL)
+	{
+		fprintf(stderr, "Cache hits: %d, misses: %d, used bytes: %lu\n",
+			counters->hits, counters->misses, (unsigned long)counters->usedBytes);
+	}
+
+	if (_powerCache != NULL)
+	{
+		fprintf(stderr, "Power cache hits: %d, reuses: %d, misses: %d, used bytes: %lu\n",
+			counters->powerHits, counters->powerReuses, counters->powerMisses, (unsigned long)counters->powerUsedBytes);
+	}
+}
+
 void FileOperations::PrintResult(Result* result)
 {
 	if (result->IsDigit())
@@ -169,13 +1799,17 @@ void FileOperations::PrintResult(Result* result)
 	}
 	else
 	{
-		if(result->condition)
+		if (_outputFormat == OUTPUT_BINARY)
+		{
+			WriteBinaryField(result->condition ? 'T' : 'F');
+		}
+		else if(result->condition)
 		{
-			printf("true\n");
+			fprintf(_outputFile, "true\n");
 		}
 		else
 		{
-			printf("false\n");
+			fprintf(_outputFile, "false\n");
 		}
 	}
 }
@@ -2,10 +2,22 @@
 #define H_FILE_OPERATIONS
 
 #include "BigInt.h"
+#include "ResultCache.h"
+#include "PreparedDivisor.h"
+#include "PowerCache.h"
+#include "TList.h"
+#include "ThreadPool.h"
+#include "Statistics.h"
+#include "Instrumentation.h"
+#include "RowScanner.h"
+#include "SmallRowBatch.h"
+#include "Reduction.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-enum Operation {ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER, GREATER, LESS, EQUALS, UNKNOWN};
+enum OutputFormat {OUTPUT_DECIMAL, OUTPUT_HEX, OUTPUT_BINARY};
+
+enum Operation {ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER, SQUARE_ROOT, ROOT, GCD, GREATER, LESS, EQUALS, UNKNOWN};
 
 struct Result
 {
@@ -29,15 +41,155 @@ struct Result
 	BigInt* digit;
 };
 
+// Операнд строки-свертки: строка в тексте пачки или "цифры" двоичного задания в общем списке пачки
+struct RowOperand
+{
+	int offset;
+	int length;
+};
+
+// Строка задания - два операнда и операция или, для + и *, свертка N операндов:
+// тогда все операнды лежат в списке операндов пачки начиная с operandsIndex
+struct Row
+{
+	BigInt* first;
+	BigInt* second;
+	int operation;
+	bool condition;
+	BigInt* digit;
+	const char* error;
+	long long nanoseconds;
+	int firstOffset;
+	int firstLength;
+	int secondOffset;
+	int secondLength;
+	int operandsCount;
+	int operandsIndex;
+	long long line;
+	bool executed;
+	int smallSize;
+	int smallDigits[2 * SmallRowBatch::limbsCount];
+};
+
+// Двоичный файл задания: заголовок, затем строки из кода операции, числа операндов и операндов.
+// Операнд - число "цифр" и сами "цифры" младшими вперед; все поля 32-битные little-endian.
+// Строка, которую конвертер не смог разобрать, пишется с нулем операндов и кодом ошибки вместо них
+// (с версии 2): при чтении она печатает то же сообщение, что и текстовое задание.
+struct BinaryJobHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int base;
+	unsigned int reserved;
+};
+
+// Счетчики кэшей результатов и степеней, сложенные по исполнителям (а при кусках - и по процессам)
+struct CacheCounters
+{
+	int hits;
+	int misses;
+	size_t usedBytes;
+	int powerHits;
+	int powerReuses;
+	int powerMisses;
+	size_t powerUsedBytes;
+};
+
+// Двоичный вывод: на каждую строку тип записи (uint32) - 'N' и число в том же виде, что операнд задания,
+// 'T' или 'F' для сравнений, 'E' с длиной и текстом сообщения для ошибок.
 class FileOperations
 {
 public:
+	static const int preparedDivisorsCount = 16;
+	static const char binaryJobMagic[4];
+	static const unsigned int binaryJobVersion = 2;
+	static const int outputChunkLength = 16384;
+
+	FileOperations();
+	~FileOperations();
+
+	void EnableCache(size_t maxBytes);
+	ResultCache* GetCache();
+	void EnablePowerCache(size_t maxBytes);
+	PowerCache* GetPowerCache();
+	void SetOutputFile(FILE* outputFile);
+	void SetOutputFormat(OutputFormat outputFormat);
+	void SetErrorFile(FILE* errorFile);
+	void SetThreadsCount(int threadsCount);
+	void SetBatchSize(int batchSize);
+	void SetLineOffset(long long lineOffset);
+	void SetThreadPinning(ThreadPinning pinning);
+	void EnableRowBatches();
+	void EnableStatistics();
+	Statistics* GetStatistics();
+	void SetCacheCountersPrinting(bool printing);
+	void AddCacheCounters(CacheCounters* counters);
+	void PrintCacheCounters(const CacheCounters* counters);
 	BigInt* ReadBigInt(FILE* inputFile, int ch);
+	BigInt* ParseBigInt(const char* stringOfDigits, int stringLength);
+	BigInt* ParseHexBigInt(const char* stringOfDigits, int stringLength);
 	void PrintBigInt(BigInt* bigInt);
+	void PrintHexBigInt(const BigInt* bigInt);
 	void ReadFromFile(FILE* inputFile);
+	void ReadTextFromFile(FILE* inputFile);
+	static long long FindRowBoundary(const char* text, long long length, long long position);
+	void ConvertToBinary(FILE* inputFile, FILE* outputFile);
+	BigInt* ReadBinaryBigInt(FILE* inputFile);
+	void WriteBinaryBigInt(FILE* outputFile, const BigInt* bigInt);
+	void ReadExpressionsFromFile(FILE* inputFile);
 	Result ExecuteOperation(int operation, BigInt* first, BigInt* second);
 	void PrintResult(Result* result);
 	void PrintError(const char* message) ;
+
+private:
+	int ReadChar(FILE* inputFile);
+	int ReadLine(FILE* inputFile, int ch, char* line);
+	void ReadRows(FILE* inputFile, bool binary);
+	bool ScanTextRow(Row* row);
+	bool ReadBinaryHeader(FILE* inputFile);
+	bool ReadBinaryRow(FILE* inputFile, Row* row);
+	void ReadBinaryReduction(FILE* inputFile, Row* row, unsigned int operandsCount);
+	void AddOperand(int offset, int length);
+	void ConvertReductionToBinary(const Row* row, FILE* outputFile);
+	unsigned int ReadBinaryField(FILE* inputFile);
+	void WriteBinaryField(unsigned int value);
+	void FlushChunk(char* chunk, int* length, int reserve);
+	void PrintLimbs(const int* digits, int size);
+	void PrintSmallDigit(const Row* row);
+	void ExecuteRows(Row* rows, int count);
+	static void ExecuteRow(FileOperations* executor, Row* row, const char* text);
+	static void ExecuteRowTask(int index, int worker, void* context);
+	static void ExecuteSmallRows(FileOperations* executor, Row* rows, int count, const char* text);
+	static void ExecuteSmallRowsTask(int index, int worker, void* context);
+	void ExecuteReduction(Row* row, const char* text);
+	static void ExecuteReductionTask(int index, int worker, void* context);
+	void PrintRows(Row* rows, int count);
+	const PreparedDivisor* GetPreparedDivisor(const BigInt* divisor);
+	void PrintStatistics();
+
+	ResultCache* _cache;
+	size_t _cacheBytes;
+	PowerCache* _powerCache;
+	size_t _powerCacheBytes;
+	TList<PreparedDivisor*> _divisors;
+	FILE* _outputFile;
+	OutputFormat _outputFormat;
+	FILE* _errorFile;
+	bool _binaryInput;
+	int _threadsCount;
+	int _batchSize;
+	bool _rowBatches;
+	SmallRowBatch* _smallRows;
+	ThreadPool* _pool;
+	ThreadPinning _pinning;
+	FileOperations* _executors;
+	Statistics* _statistics;
+	bool _cacheCountersPrinting;
+	long long _bytesRead;
+	long long _lineOffset;
+	RowScanner _scanner;
+	TList<RowOperand> _operands;
+	TList<int> _operandLimbs;
 };
 
 #endif
@@ -3,6 +3,14 @@
 #include "TList.h"
 #include "BigInt.h"
 #include "UnitTestsHelper.h"
+#include "AsyncIo.h"
+#include "Shards.h"
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#include <signal.h>
+#include <sys/resource.h>
+#endif
 
 void WriteDataToFile(char* fileName, char* string) 
 {
@@ -178,4 +186,811 @@ TEST(ReadFileTest, ShouldExecuteSeveralOperationsFromFile)
 	FileOperations operations;
 	operations.ReadFromFile(inputFile);
 	fclose(inputFile);
-}
\ No newline at end of file
+}
+
+std::string ExecuteExpressions(char* lines)
+{
+	char* fileName = "Tests/in";
+	WriteDataToFile(fileName, lines);
+
+	FILE* inputFile = fopen(fileName, "r");
+	FileOperations operations;
+	testing::internal::CaptureStdout();
+	operations.ReadExpressionsFromFile(inputFile);
+	fclose(inputFile);
+
+	return testing::internal::GetCapturedStdout();
+}
+
+TEST(ExpressionTest, ShouldEvaluateRpn)
+{
+	std::string output = ExecuteExpressions("1234567899876543 1234567899876543 + 2 *\n12 8 ^ 2 -");
+
+	ASSERT_EQ("4938271599506172\n429981694\n", output);
+}
+
+TEST(ExpressionTest, ShouldKeepVariablesBetweenLines)
+{
+	std::string output = ExecuteExpressions("a := 99999999 99999999 *\nb := a a +\nb a 2 * =\nb\nb a -");
+
+	ASSERT_EQ("true\n19999999600000002\n9999999800000001\n", output);
+}
+
+TEST(ExpressionTest, ShouldAccumulateInPlace)
+{
+	std::string output = ExecuteExpressions("s := 0\ns := s 99999999 +\ns := s 99999999 +\ns := s 1 -\ns");
+
+	ASSERT_EQ("199999997\n", output);
+}
+
+TEST(ExpressionTest, ShouldKeepVariableIfAssignmentFailed)
+{
+	std::string output = ExecuteExpressions("s := 5\ns := s 1 + 0 /\ns\ns := s 2 + 3 + 100000000 ! +\ns");
+
+	ASSERT_EQ("Error\n5\nError\n5\n", output);
+}
+
+TEST(ExpressionTest, ShouldReuseCommonSubexpressions)
+{
+	std::string output = ExecuteExpressions("123456789 987654321 * 987654321 123456789 * +\n10000 Q 2 R 10 G");
+
+	ASSERT_EQ("243865262225270538\n10\n", output);
+}
+
+TEST(ExpressionTest, ShouldEvaluateCombinatorialOperations)
+{
+	std::string output = ExecuteExpressions("25 !\n52 5 C\n5 ! 1 5 P =\n100000000 !");
+
+	ASSERT_EQ("15511210043330985984000000\n2598960\ntrue\nError\n", output);
+}
+
+TEST(ExpressionTest, ShouldPrintErrorAndContinue)
+{
+	std::string output = ExecuteExpressions("1 +\nx 1 +\n1 0 /\n2 3 ^");
+
+	ASSERT_EQ("Wrong input format.\nWrong input format.\nError\n8\n", output);
+}
+
+TEST(ResultCacheTest, ShouldReturnCachedResultForRepeatedRow)
+{
+	BigInt* first = ReadBigInt("123456789987");
+	BigInt* second = ReadBigInt("123");
+	FileOperations operations;
+	operations.EnableCache(1024 * 1024);
+
+	Result result = operations.ExecuteOperation('^', first, second);
+	Result cached = operations.ExecuteOperation('^', first, second);
+
+	ASSERT_EQ(1, operations.GetCache()->GetHits());
+	ASSERT_EQ(1, operations.GetCache()->GetMisses());
+	ASSERT_TRUE(AreEquals(result.digit, cached.digit));
+	ASSERT_TRUE(result.digit != cached.digit);
+}
+
+TEST(ResultCacheTest, ShouldDistinguishOperations)
+{
+	BigInt* first = ReadBigInt("123456790");
+	BigInt* second = ReadBigInt("123456789");
+	FileOperations operations;
+	operations.EnableCache(1024 * 1024);
+
+	Result greater = operations.ExecuteOperation('>', first, second);
+	Result less = operations.ExecuteOperation('<', first, second);
+	Result sum = operations.ExecuteOperation('+', first, second);
+
+	ASSERT_EQ(0, operations.GetCache()->GetHits());
+	ASSERT_TRUE(greater.condition);
+	ASSERT_FALSE(less.condition);
+	ASSERT_TRUE(sum.IsDigit());
+}
+
+TEST(ResultCacheTest, ShouldEvictLeastRecentlyUsed)
+{
+	BigInt* first = ReadBigInt("1234567899876543");
+	BigInt* second = ReadBigInt("2");
+	BigInt* third = ReadBigInt("3");
+	FileOperations operations;
+	operations.EnableCache(2 * (sizeof(CacheEntry) + 20 * sizeof(int)));
+
+	Result a = operations.ExecuteOperation('*', first, second);
+	Result b = operations.ExecuteOperation('*', first, third);
+	Result c = operations.ExecuteOperation('*', first, second);
+	Result d = operations.ExecuteOperation('+', first, third);
+	Result e = operations.ExecuteOperation('*', first, second);
+	Result f = operations.ExecuteOperation('*', first, third);
+
+	ASSERT_EQ(2, operations.GetCache()->GetHits());
+	ASSERT_EQ(4, operations.GetCache()->GetMisses());
+}
+
+TEST(PowerCacheTest, ShouldReuseCachedPowersOfSameBase)
+{
+	BigInt* base = ReadBigInt("123456789");
+	BigInt* thousand = ReadBigInt("1000");
+	BigInt* thousandOne = ReadBigInt("1001");
+	BigInt* twoThousand = ReadBigInt("2000");
+	FileOperations operations;
+	operations.EnablePowerCache(64 * 1024 * 1024);
+
+	Result first = operations.ExecuteOperation('^', base, thousand);
+	Result second = operations.ExecuteOperation('^', base, thousandOne);
+	Result third = operations.ExecuteOperation('^', base, twoThousand);
+	Result repeated = operations.ExecuteOperation('^', base, thousand);
+
+	BigInt* expected = Power(base, twoThousand);
+	ASSERT_TRUE(AreEquals(expected, third.digit));
+	BigInt* expectedNext = Multiply(first.digit, base);
+	ASSERT_TRUE(AreEquals(expectedNext, second.digit));
+	ASSERT_TRUE(AreEquals(first.digit, repeated.digit));
+	ASSERT_EQ(1, operations.GetPowerCache()->GetMisses());
+	ASSERT_EQ(2, operations.GetPowerCache()->GetReuses());
+	ASSERT_EQ(1, operations.GetPowerCache()->GetHits());
+}
+
+TEST(PowerCacheTest, ShouldStayWithinMemoryLimit)
+{
+	BigInt* two = ReadBigInt("2");
+	BigInt* three = ReadBigInt("3");
+	BigInt* power = ReadBigInt("100");
+	FileOperations operations;
+	operations.EnablePowerCache(12 * sizeof(BigInt));
+
+	Result first = operations.ExecuteOperation('^', two, power);
+	Result second = operations.ExecuteOperation('^', three, power);
+
+	ASSERT_TRUE(operations.GetPowerCache()->GetUsedBytes() <= 12 * sizeof(BigInt));
+	ASSERT_TRUE(AreEquals(Power(three, power), second.digit));
+}
+
+TEST(PowerCacheTest, ShouldStayWithinMemoryLimitOnOverflow)
+{
+	BigInt* three = ReadBigInt("3");
+	BigInt* hugePower = ReadBigInt("99999999");
+	BigInt* base = ReadBigInt("9999");
+	BigInt* power = ReadBigInt("50001");
+	FileOperations operations;
+	operations.EnablePowerCache(12 * sizeof(BigInt));
+
+	try
+	{
+		operations.ExecuteOperation('^', three, hugePower);
+		ASSERT_FALSE(true);
+	}
+	catch (AppException e)
+	{
+		ASSERT_EQ(0, operations.GetPowerCache()->GetUsedBytes());
+	}
+
+	//Оценка снизу пропускает 9999^50001, и переполнение находит умножение
+	try
+	{
+		operations.ExecuteOperation('^', base, power);
+	}
+	catch (AppException e)
+	{
+		ASSERT_STREQ("Error", e.GetMessage());
+		ASSERT_TRUE(operations.GetPowerCache()->GetUsedBytes() <= 12 * sizeof(BigInt));
+		return;
+	}
+
+	ASSERT_FALSE(true);
+}
+
+std::string ReadOutput(FILE* outputFile)
+{
+	std::string output;
+	rewind(outputFile);
+	for (int ch = fgetc(outputFile); ch != EOF; ch = fgetc(outputFile))
+	{
+		output += (char)ch;
+	}
+	fclose(outputFile);
+
+	return output;
+}
+
+std::string ExecuteRows(char* lines, int threadsCount, Statistics** statistics)
+{
+	char* fileName = "Tests/in";
+	WriteDataToFile(fileName, lines);
+
+	FILE* inputFile = fopen(fileName, "r");
+	FILE* outputFile = tmpfile();
+	FileOperations operations;
+	operations.SetOutputFile(outputFile);
+	operations.SetThreadsCount(threadsCount);
+	operations.SetBatchSize(3);
+	operations.EnableStatistics();
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+
+	if (statistics != NULL)
+	{
+		*statistics = new Statistics(*operations.GetStatistics());
+	}
+
+	return ReadOutput(outputFile);
+}
+
+TEST(ThreadPoolTest, ShouldPrintRowsInInputOrder)
+{
+	char* lines = "99999999\n99999999\n*\n10\n0\n/\n12345678901234\n1234\n+\n2\n100\n^\n5\n3\n>\n100000000\n1\n-\n7\n7\n=";
+
+	std::string single = ExecuteRows(lines, 1, NULL);
+	std::string parallel = ExecuteRows(lines, 4, NULL);
+
+	ASSERT_EQ("9999999800000001\nError\n12345678902468\n1267650600228229401496703205376\ntrue\n99999999\ntrue\n", single);
+	ASSERT_EQ(single, parallel);
+}
+
+TEST(ThreadPoolTest, ShouldGiveSameResultsWhenThreadsArePinned)
+{
+	char* lines = "99999999\n99999999\n*\n12345678901234\n1234\n+\n2\n100\n^\n100000000\n1\n-";
+	ThreadPinning pinnings[] = {PIN_CPUS, PIN_NUMA_NODES};
+
+	for (int i = 0; i < 2; i++)
+	{
+		WriteDataToFile("Tests/in", lines);
+		FILE* inputFile = fopen("Tests/in", "r");
+		FILE* outputFile = tmpfile();
+		FileOperations operations;
+		operations.SetOutputFile(outputFile);
+		operations.SetThreadsCount(3);
+		operations.SetThreadPinning(pinnings[i]);
+		operations.ReadFromFile(inputFile);
+		fclose(inputFile);
+
+		ASSERT_EQ(ExecuteRows(lines, 1, NULL), ReadOutput(outputFile));
+	}
+}
+
+std::string ExecuteRowBatches(char* lines, int threadsCount)
+{
+	WriteDataToFile("Tests/in", lines);
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FILE* outputFile = tmpfile();
+	FileOperations operations;
+	operations.SetOutputFile(outputFile);
+	operations.SetThreadsCount(threadsCount);
+	operations.EnableRowBatches();
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+
+	return ReadOutput(outputFile);
+}
+
+TEST(RowBatchTest, ShouldGiveSameResultsAsRowByRow)
+{
+	char* lines = "99999999\n99999999\n*\n12\n123\n-\n10\n0\n/\n99999999999999999999999999999999\n1\n+\n"
+		"000\n0\n=\n5\n3\n>\n123456789012345678901234567890123\n2\n*\n0x10\n1\n+\n12a\n1\n+\n"
+		"100000000\n1\n-\n7\n8\n<\n0\n12345\n*";
+
+	std::string expected = ExecuteRows(lines, 1, NULL);
+
+	ASSERT_EQ(expected, ExecuteRowBatches(lines, 1));
+	ASSERT_EQ(expected, ExecuteRowBatches(lines, 3));
+}
+
+TEST(ReductionRowTest, ShouldReduceManyOperands)
+{
+	std::string lines;
+	for (int i = 1; i <= 1000; i++)
+	{
+		lines += std::to_string(i) + "\n";
+	}
+	lines += "+\n";
+	for (int i = 1; i <= 30; i++)
+	{
+		lines += std::to_string(i) + "\n";
+	}
+	lines += "*\n99999999\n1\n99999999\n+\n5\n0\n7\n*";
+
+	std::string single = ExecuteRows((char*)lines.c_str(), 1, NULL);
+	std::string parallel = ExecuteRows((char*)lines.c_str(), 3, NULL);
+
+	ASSERT_EQ("500500\n265252859812191058636308480000000\n199999999\n0\n", single);
+	ASSERT_EQ(single, parallel);
+}
+
+TEST(ReductionRowTest, ShouldGiveZeroProductWhateverOperandsOrder)
+{
+	//Двоичные операнды по 30000 "цифр": произведение любых двух переполняется сразу, без умножения
+	const char* rows[] = {"bbb0", "0bbb", "bbbb"};
+	std::vector<unsigned int> job;
+	for (int row = 0; row < 3; row++)
+	{
+		job.push_back('*');
+		job.push_back(4);
+		for (int i = 0; i < 4; i++)
+		{
+			if (rows[row][i] == '0')
+			{
+				job.push_back(1);
+				job.push_back(0);
+				continue;
+			}
+			job.push_back(30000);
+			job.insert(job.end(), 29999, 0);
+			job.push_back(1);
+		}
+	}
+
+	for (int threadsCount = 1; threadsCount <= 3; threadsCount += 2)
+	{
+		FILE* binaryFile = tmpfile();
+		BinaryJobHeader header = {{'L', '6', 'J', 'B'}, FileOperations::binaryJobVersion, BigInt::base, 0};
+		fwrite(&header, sizeof(header), 1, binaryFile);
+		fwrite(job.data(), sizeof(unsigned int), job.size(), binaryFile);
+		rewind(binaryFile);
+
+		FileOperations operations;
+		FILE* outputFile = tmpfile();
+		operations.SetOutputFile(outputFile);
+		operations.SetThreadsCount(threadsCount);
+		operations.ReadFromFile(binaryFile);
+		fclose(binaryFile);
+
+		ASSERT_EQ("0\n0\nError\n", ReadOutput(outputFile));
+	}
+}
+
+TEST(ReductionRowTest, ShouldRejectManyOperandsForOtherOperations)
+{
+	std::string output = ExecuteRows("9\n2\n1\n-\n2\n2\n2\n^\n3\n4\n*", 3, NULL);
+
+	ASSERT_EQ("Wrong input format.\nWrong input format.\n12\n", output);
+}
+
+#ifdef __linux__
+std::string ExecuteAsyncRows(AsyncIoBackend backend)
+{
+	FILE* inputFile = OpenAsyncInput(fopen("Tests/in", "r"), backend);
+	FILE* outputFile = tmpfile();
+	FILE* asyncOutputFile = OpenAsyncOutput(fdopen(dup(fileno(outputFile)), "w"), backend);
+	FileOperations operations;
+	operations.SetOutputFile(asyncOutputFile);
+	operations.SetThreadsCount(2);
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+	fclose(asyncOutputFile);
+
+	return ReadOutput(outputFile);
+}
+
+//Вход и вывод - несколько блоков, чтобы переключение буферов прошло и по границе блока, и в хвосте
+TEST(AsyncIoTest, ShouldGiveSameResultsAsPlainFiles)
+{
+	std::string lines;
+	std::string expected;
+	for (int i = 0; lines.size() < (size_t)(3 * asyncBlockLength); i++)
+	{
+		std::string digit(1000 + i % 7, (char)('1' + i % 9));
+		lines += digit + "\n0\n+\n";
+		expected += digit + "\n";
+	}
+	lines.erase(lines.size() - 1);
+	WriteDataToFile("Tests/in", (char*)lines.c_str());
+
+	ASSERT_EQ(expected, ExecuteAsyncRows(ASYNC_IO_URING));
+	ASSERT_EQ(expected, ExecuteAsyncRows(ASYNC_IO_THREAD));
+}
+
+TEST(ShardTest, ShouldSplitAfterOperationLines)
+{
+	const char* text = "12\n3\n+\n7\r\n-\r\n5\n";
+	long long length = (long long)strlen(text);
+
+	ASSERT_EQ(0, FileOperations::FindRowBoundary(text, length, 0));
+	ASSERT_EQ(7, FileOperations::FindRowBoundary(text, length, 1));
+	ASSERT_EQ(7, FileOperations::FindRowBoundary(text, length, 5));
+	ASSERT_EQ(13, FileOperations::FindRowBoundary(text, length, 7));
+	ASSERT_EQ(length, FileOperations::FindRowBoundary(text, length, 13));
+}
+
+//Вывод и номера строк в ошибках те же, что у одного процесса, и при кусках меньше строки задания
+TEST(ShardTest, ShouldGiveSameOutputAndErrorsAsOneProcess)
+{
+	std::string lines;
+	for (int i = 0; i < 300; i++)
+	{
+		lines += std::to_string(i * 7919) + (i % 17 == 0 ? "x" : "") + "\n" + std::to_string(i) + "\n" + "+-*/<"[i % 5] + "\n";
+	}
+	lines += "1\n2\n3\n+\n5";
+	WriteDataToFile("Tests/in", (char*)lines.c_str());
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FILE* outputFile = tmpfile();
+	FILE* errorFile = tmpfile();
+	FileOperations single;
+	single.SetOutputFile(outputFile);
+	single.SetErrorFile(errorFile);
+	single.EnableStatistics();
+	single.ReadFromFile(inputFile);
+	fclose(inputFile);
+	std::string expected = ReadOutput(outputFile);
+	std::string expectedErrors = ReadOutput(errorFile);
+
+	int processesCounts[] = {2, 7, 64};
+	for (int i = 0; i < 3; i++)
+	{
+		int processesCount = processesCounts[i];
+		inputFile = fopen("Tests/in", "r");
+		outputFile = tmpfile();
+		errorFile = tmpfile();
+		FileOperations operations;
+		operations.SetThreadsCount(2);
+		operations.EnableStatistics();
+
+		ASSERT_EQ(SHARDS_DONE, ExecuteShards(&operations, inputFile, outputFile, errorFile, processesCount, true));
+		fclose(inputFile);
+
+		ASSERT_EQ(expected, ReadOutput(outputFile));
+		ASSERT_EQ(expectedErrors, ReadOutput(errorFile));
+		ASSERT_EQ(single.GetStatistics()->GetRows(), operations.GetStatistics()->GetRows());
+	}
+}
+
+//Вывод второго куска больше предела размера файла: его процесс не может дописать вывод и выходит с ошибкой
+TEST(ShardTest, ShouldNotAppendOutputOfFailedShard)
+{
+	std::string lines;
+	std::string expected;
+	for (int i = 0; i < 12; i++)
+	{
+		lines += "1\n1\n+\n";
+		expected += "2\n";
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		lines += "9\n30000\n^\n";
+	}
+	WriteDataToFile("Tests/in", (char*)lines.c_str());
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FILE* outputFile = tmpfile();
+	FILE* errorFile = tmpfile();
+	FileOperations operations;
+	struct rlimit limit;
+	getrlimit(RLIMIT_FSIZE, &limit);
+	struct rlimit smallLimit = limit;
+	smallLimit.rlim_cur = 65536;
+	setrlimit(RLIMIT_FSIZE, &smallLimit);
+	void (*handler)(int) = signal(SIGXFSZ, SIG_IGN);
+
+	ShardsResult result = ExecuteShards(&operations, inputFile, outputFile, errorFile, 2, false);
+	setrlimit(RLIMIT_FSIZE, &limit);
+	signal(SIGXFSZ, handler);
+	fclose(inputFile);
+
+	ASSERT_EQ(SHARDS_FAILED, result);
+	ASSERT_EQ(expected, ReadOutput(outputFile));
+	ASSERT_EQ("Shard 2: Error\n", ReadOutput(errorFile));
+}
+#endif
+
+TEST(StatisticsTest, ShouldCountRowsPerOperation)
+{
+	Statistics* statistics = NULL;
+	ExecuteRows("1\n2\n+\n3\n4\n+\n5\n6\n*", 2, &statistics);
+
+	ASSERT_EQ(3, statistics->GetRows());
+	ASSERT_EQ(2, statistics->GetCount('+'));
+	ASSERT_EQ(1, statistics->GetCount('*'));
+	long long bucketed = 0;
+	for (int i = 0; i < Statistics::bucketsCount; i++)
+	{
+		bucketed += statistics->GetBucket('+', i);
+	}
+	ASSERT_EQ(2, bucketed);
+	delete statistics;
+}
+
+TEST(StatisticsTest, ShouldKeepRelativeBucketError)
+{
+	for (long long value = 1; value < 4000000000LL; value = value * 3 + 1)
+	{
+		int bucket = Statistics::GetBucketIndex(value);
+		long long lower = Statistics::GetBucketLowerBound(bucket);
+		long long upper = Statistics::GetBucketLowerBound(bucket + 1);
+
+		ASSERT_TRUE(lower <= value && value < upper);
+		ASSERT_TRUE((upper - lower) * 8 <= (lower < 8 ? 8 : lower));
+	}
+}
+
+std::string PrintJson(Statistics* statistics)
+{
+	FILE* jsonFile = tmpfile();
+	statistics->PrintJson(jsonFile);
+	std::string json;
+	rewind(jsonFile);
+	for (int ch = fgetc(jsonFile); ch != EOF; ch = fgetc(jsonFile))
+	{
+		json += (char)ch;
+	}
+	fclose(jsonFile);
+
+	return json;
+}
+
+TEST(StatisticsTest, ShouldSplitTimeByPhase)
+{
+	Statistics* statistics = NULL;
+	ExecuteRows("1\n2\n+\n3\n4\n*", 1, &statistics);
+	std::string json = PrintJson(statistics);
+
+	ASSERT_TRUE(statistics->GetPhase(PHASE_PARSE) > 0);
+	ASSERT_TRUE(statistics->GetPhase(PHASE_COMPUTE) > 0);
+	ASSERT_NE(std::string::npos, json.find("\"rows\": 2,"));
+	ASSERT_NE(std::string::npos, json.find("\"*\": {\"rows\": 1"));
+	delete statistics;
+}
+
+TEST(StatisticsTest, ShouldGiveUnprintableOperationsOwnKeys)
+{
+	Statistics* statistics = NULL;
+	ExecuteRows("1\n2\n\x01\n3\n4\n\"\n5\n6\n\x02", 1, &statistics);
+	std::string json = PrintJson(statistics);
+
+	ASSERT_NE(std::string::npos, json.find("\"op_1\": {\"rows\": 1"));
+	ASSERT_NE(std::string::npos, json.find("\"op_2\": {\"rows\": 1"));
+	ASSERT_NE(std::string::npos, json.find("\"op_34\": {\"rows\": 1"));
+	delete statistics;
+}
+
+#ifdef LAB6_INSTRUMENTATION
+TEST(InstrumentationTest, ShouldCountKernelCallsAndAllocations)
+{
+	//Операнд шире FixedBigInt, чтобы строки шли через BigInt
+	std::string big = "1" + std::string(400, '0');
+	std::string lines = big + "\n89\n*\n" + big + "\n89\n+";
+	ResetKernelCounters();
+	ExecuteRows((char*)lines.c_str(), 2, NULL);
+
+	KernelCounters counters;
+	GetKernelCounters(&counters);
+
+	ASSERT_EQ(1, counters.calls[KERNEL_MULTIPLY]);
+	ASSERT_EQ(101, counters.limbs[KERNEL_MULTIPLY]);
+	ASSERT_EQ(1, counters.calls[KERNEL_ADD]);
+	ASSERT_EQ(4, counters.calls[KERNEL_PARSE]);
+	ASSERT_EQ(2, counters.calls[KERNEL_PRINT]);
+	ASSERT_EQ(6, counters.allocations);
+}
+
+TEST(InstrumentationTest, ShouldCountFixedWidthRows)
+{
+	ResetKernelCounters();
+	ExecuteRows("1234567\n89\n*\n1234567\n89\n+", 2, NULL);
+
+	KernelCounters counters;
+	GetKernelCounters(&counters);
+
+	ASSERT_EQ(2, counters.calls[KERNEL_FIXED]);
+	ASSERT_EQ(0, counters.calls[KERNEL_MULTIPLY]);
+	ASSERT_EQ(0, counters.calls[KERNEL_PARSE]);
+	ASSERT_EQ(2, counters.allocations);
+}
+#endif
+
+TEST(BinaryJobTest, ShouldGiveSameResultsAsTextJob)
+{
+	char* lines = "123456789012345678901234567890\n987654321\n*\n100000000\n1\n-\n0\n5\n+\n2\n100\n^\n10\n0\n/\n5\n3\n<\n1\n2\n3\n4\n+\n2\n3\n4\n*";
+	std::string text = ExecuteRows(lines, 1, NULL);
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FILE* binaryFile = tmpfile();
+	FileOperations converter;
+	converter.ConvertToBinary(inputFile, binaryFile);
+	fclose(inputFile);
+
+	rewind(binaryFile);
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.ReadFromFile(binaryFile);
+	fclose(binaryFile);
+
+	ASSERT_EQ(text, ReadOutput(outputFile));
+}
+
+TEST(BinaryJobTest, ShouldKeepOperationAndErrorOfMalformedRows)
+{
+	char* lines = "1x\n2\n+\n1\n2\n3\n-\n5\n3\n-\n1\n2\n3x\n*";
+	std::string text = ExecuteRows(lines, 1, NULL);
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FILE* binaryFile = tmpfile();
+	FileOperations converter;
+	converter.ConvertToBinary(inputFile, binaryFile);
+	fclose(inputFile);
+
+	rewind(binaryFile);
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.EnableStatistics();
+	operations.ReadFromFile(binaryFile);
+	fclose(binaryFile);
+	std::string json = PrintJson(operations.GetStatistics());
+
+	ASSERT_EQ(text, ReadOutput(outputFile));
+	ASSERT_EQ("Wrong input format.\nWrong input format.\n2\nWrong input format.\n", text);
+	ASSERT_NE(std::string::npos, json.find("\"+\": {\"rows\": 1"));
+	ASSERT_NE(std::string::npos, json.find("\"-\": {\"rows\": 2"));
+	ASSERT_NE(std::string::npos, json.find("\"*\": {\"rows\": 1"));
+	ASSERT_EQ(std::string::npos, json.find("\"op_0\""));
+
+	binaryFile = tmpfile();
+	BinaryJobHeader header = {{'L', '6', 'J', 'B'}, FileOperations::binaryJobVersion, BigInt::base, 0};
+	unsigned int rows[] = {'-', 0, 1, '+', 0, 0, '+', 2, 1, 7, 1, 5};
+	fwrite(&header, sizeof(header), 1, binaryFile);
+	fwrite(rows, sizeof(rows), 1, binaryFile);
+	rewind(binaryFile);
+
+	outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.ReadFromFile(binaryFile);
+	fclose(binaryFile);
+	ASSERT_EQ("Error\nWrong input format.\n12\n", ReadOutput(outputFile));
+}
+
+TEST(BinaryJobTest, ShouldRejectWrongHeaderAndTruncatedRows)
+{
+	FILE* binaryFile = tmpfile();
+	BinaryJobHeader header = {{'L', '6', 'J', 'B'}, FileOperations::binaryJobVersion, 10, 0};
+	fwrite(&header, sizeof(header), 1, binaryFile);
+	rewind(binaryFile);
+
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.ReadFromFile(binaryFile);
+	fclose(binaryFile);
+	ASSERT_EQ("Wrong input format.\n", ReadOutput(outputFile));
+
+	binaryFile = tmpfile();
+	header.base = BigInt::base;
+	unsigned int row[] = {'+', 2, 1, 7, 1, 5, '*', 2, 3, 1};
+	fwrite(&header, sizeof(header), 1, binaryFile);
+	fwrite(row, sizeof(row), 1, binaryFile);
+	rewind(binaryFile);
+
+	outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.ReadFromFile(binaryFile);
+	fclose(binaryFile);
+	ASSERT_EQ("12\nWrong input format.\n", ReadOutput(outputFile));
+}
+
+TEST(OutputFormatTest, ShouldPrintHexAndReadItBack)
+{
+	WriteDataToFile("Tests/in", "18446744073709551616\n1\n-\n0x1F\n0XfF\n+\n255\n0xff\n=\n0\n0\n+");
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.SetOutputFormat(OUTPUT_HEX);
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+
+	ASSERT_EQ("0xffffffffffffffff\n0x11e\ntrue\n0x0\n", ReadOutput(outputFile));
+
+	BigInt* digit = ReadBigInt("0x123456789abcdef0123456789abcdef");
+	BigInt* expected = ReadBigInt("1512366075204170929049582354406559215");
+	ASSERT_TRUE(AreEquals(expected, digit));
+	delete digit;
+	delete expected;
+}
+
+TEST(OutputFormatTest, ShouldDumpBinaryRecords)
+{
+	WriteDataToFile("Tests/in", "99999\n1\n+\n1\n2\n>\n1\n0\n/");
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.SetOutputFormat(OUTPUT_BINARY);
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+
+	unsigned int expected[] = {'N', 2, 0, 10, 'F', 'E', 5};
+	unsigned int record[7];
+	char message[6] = {0};
+	rewind(outputFile);
+	ASSERT_EQ(7, fread(record, sizeof(unsigned int), 7, outputFile));
+	ASSERT_EQ(5, fread(message, 1, 5, outputFile));
+	fclose(outputFile);
+
+	for (int i = 0; i < 7; i++)
+	{
+		ASSERT_EQ(expected[i], record[i]);
+	}
+	ASSERT_STREQ("Error", message);
+}
+
+TEST(OutputFormatTest, ShouldPrintResultsLongerThanChunk)
+{
+	BigInt* digit = new BigInt();
+	digit->size = 3 * FileOperations::outputChunkLength / BigInt::baseDimentions + 5;
+	std::string expected;
+	for (int i = digit->size - 1; i >= 0; i--)
+	{
+		digit->digits[i] = (i * 37 + 1) % BigInt::base;
+		char limb[8];
+		sprintf(limb, i == digit->size - 1 ? "%d" : "%.4d", digit->digits[i]);
+		expected += limb;
+	}
+	expected += "\n";
+
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.PrintBigInt(digit);
+	delete digit;
+
+	ASSERT_EQ(expected, ReadOutput(outputFile));
+}
+
+TEST(ComparisonTest, ShouldCompareRowsWithoutParsing)
+{
+	char* lines = "000123\n123\n=\n99\n100\n<\n12345678901234567890\n12345678901234567891\n>\n12345678901234567891\n12345678901234567890\n>\n0\n000\n=\n255\n0xff\n=\n0x100\n255\n>";
+
+	std::string output = ExecuteRows(lines, 1, NULL);
+
+	ASSERT_EQ("true\ntrue\nfalse\ntrue\ntrue\ntrue\ntrue\n", output);
+}
+
+TEST(ComparisonTest, ShouldShortCircuitRowsDecidedByText)
+{
+	char* lines = "123456789123456789\n000\n*\n0\n5\n*\n12\n123\n-\n12\n123\n/\n123\n12\n/\n0x10\n0\n*";
+
+	std::string single = ExecuteRows(lines, 1, NULL);
+	std::string parallel = ExecuteRows(lines, 3, NULL);
+
+	ASSERT_EQ("0\n0\nError\n0\n10\n0\n", single);
+	ASSERT_EQ(single, parallel);
+}
+
+TEST(ValidationTest, ShouldReportBadRowsAndResync)
+{
+	WriteDataToFile("Tests/in", "12\n3\n+\n12a45\n1\n+\n1 2\n2\n<\n5\n+\n7\n8\n9\n-\n4\n4\n*\n\n\n");
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	FILE* errorFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.SetErrorFile(errorFile);
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+
+	ASSERT_EQ("15\nWrong input format.\nWrong input format.\nWrong input format.\nWrong input format.\n16\n", ReadOutput(outputFile));
+	ASSERT_EQ("Line 4: Wrong input format.\nLine 7: Wrong input format.\nLine 10: Wrong input format.\nLine 12: Wrong input format.\n", ReadOutput(errorFile));
+}
+
+TEST(ValidationTest, ShouldRejectTooLongOperandWithoutStoppingRun)
+{
+	std::string lines(BigInt::maxDecDigitsCount + 10, '7');
+	lines += "\n1\n+\n2\n2\n*";
+	WriteDataToFile("Tests/in", (char*)lines.c_str());
+
+	FILE* inputFile = fopen("Tests/in", "r");
+	FileOperations operations;
+	FILE* outputFile = tmpfile();
+	operations.SetOutputFile(outputFile);
+	operations.ReadFromFile(inputFile);
+	fclose(inputFile);
+
+	ASSERT_EQ("Wrong input format.\n4\n", ReadOutput(outputFile));
+}
+
+TEST(ValidationTest, ShouldCheckEveryByteOfLongOperands)
+{
+	std::string output = ExecuteRows("12345678:0123456\n1\n+\n1234567/90123456\n1\n+\n12345678901234567\n1\n+\n123456789012345\x7f\n1\n=", 1, NULL);
+
+	ASSERT_EQ("Wrong input format.\nWrong input format.\n12345678901234568\nWrong input format.\n", output);
+}
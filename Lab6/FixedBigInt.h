@@ -0,0 +1,123 @@
+#ifndef H_FIXED_BIG_INT
+#define H_FIXED_BIG_INT
+
+#include "BigInt.h"
+#include <string.h>
+
+#if defined(__clang__)
+#define LAB6_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define LAB6_UNROLL _Pragma("GCC unroll 128")
+#else
+#define LAB6_UNROLL
+#endif
+
+// Число фиксированной ширины: Limbs "цифр" по основанию BigInt::base, неиспользуемые старшие - нули.
+// Ширина известна при компиляции: циклы идут по всем "цифрам" без size и разворачиваются,
+// а число целиком лежит на стеке. Для операндов до ~1024 бит вместо BigInt на 200 КБ.
+template <int Limbs>
+struct FixedBigInt
+{
+	static constexpr int limbsCount = Limbs;
+	static constexpr int maxDecDigitsCount = Limbs * BigInt::baseDimentions;
+
+	int digits[Limbs];
+};
+
+//false, если число не помещается
+template <int Limbs>
+bool FromBigInt(const BigInt* bigInt, FixedBigInt<Limbs>* result)
+{
+	if (bigInt->size > Limbs)
+	{
+		return false;
+	}
+
+	memcpy(result->digits, bigInt->digits, bigInt->size * sizeof(int));
+	memset(result->digits + bigInt->size, 0, (Limbs - bigInt->size) * sizeof(int));
+	return true;
+}
+
+template <int Limbs>
+BigInt* ToBigInt(const FixedBigInt<Limbs>* digit)
+{
+	BigInt* result = new BigInt(0, Limbs);
+	memcpy(result->digits, digit->digits, Limbs * sizeof(int));
+	result->size = DeleteExtraZeros(Limbs, result);
+	return result;
+}
+
+//false при переполнении ширины
+template <int Limbs>
+bool Add(const FixedBigInt<Limbs>* left, const FixedBigInt<Limbs>* right, FixedBigInt<Limbs>* result)
+{
+	int carry = 0;
+	LAB6_UNROLL
+	for (int i = 0; i < Limbs; i++)
+	{
+		int sum = left->digits[i] + right->digits[i] + carry;
+		carry = sum >= BigInt::base ? 1 : 0;
+		result->digits[i] = sum - carry * BigInt::base;
+	}
+
+	return carry == 0;
+}
+
+//false, если вычитаемое больше
+template <int Limbs>
+bool Subtract(const FixedBigInt<Limbs>* left, const FixedBigInt<Limbs>* right, FixedBigInt<Limbs>* result)
+{
+	int borrow = 0;
+	LAB6_UNROLL
+	for (int i = 0; i < Limbs; i++)
+	{
+		int subtraction = left->digits[i] - right->digits[i] - borrow;
+		borrow = subtraction < 0 ? 1 : 0;
+		result->digits[i] = subtraction + borrow * BigInt::base;
+	}
+
+	return borrow == 0;
+}
+
+//Произведения копятся в 64-битных столбцах без переносов (Limbs * base^2 далеко до 2^64),
+//переносы расставляются одним проходом в конце
+template <int Limbs>
+void Multiply(const FixedBigInt<Limbs>* left, const FixedBigInt<Limbs>* right, FixedBigInt<2 * Limbs>* result)
+{
+	unsigned long long columns[2 * Limbs] = {0};
+	for (int i = 0; i < Limbs; i++)
+	{
+		unsigned long long digit = (unsigned long long)left->digits[i];
+		LAB6_UNROLL
+		for (int j = 0; j < Limbs; j++)
+		{
+			columns[i + j] += digit * (unsigned int)right->digits[j];
+		}
+	}
+
+	unsigned long long carry = 0;
+	LAB6_UNROLL
+	for (int i = 0; i < 2 * Limbs; i++)
+	{
+		unsigned long long value = columns[i] + carry;
+		carry = value / BigInt::base;
+		result->digits[i] = (int)(value - carry * BigInt::base);
+	}
+}
+
+//<0, 0 или >0, как strcmp
+template <int Limbs>
+int Compare(const FixedBigInt<Limbs>* left, const FixedBigInt<Limbs>* right)
+{
+	for (int i = Limbs - 1; i >= 0; i--)
+	{
+		if (left->digits[i] != right->digits[i])
+		{
+			return left->digits[i] - right->digits[i];
+		}
+	}
+
+	return 0;
+}
+
+#endif
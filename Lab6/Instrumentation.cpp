@@ -0,0 +1,109 @@
+#include "Instrumentation.h"
+#include "Statistics.h"
+#include "TList.h"
+#include <mutex>
+#include <string.h>
+
+static const char* kernelNames[KERNELS_COUNT] =
+{
+	"add", "subtract", "multiply", "multiply_short", "divide", "divide_short",
+	"power", "square_root", "root", "gcd", "compare", "parse", "print", "fixed"
+};
+
+//Счетчики каждого потока регистрируются один раз и живут до конца программы,
+//поэтому на горячем пути нет ни блокировок, ни атомарных операций
+static std::mutex registryMutex;
+static TList<KernelCounters*> registry;
+
+struct KernelCountersRegistry
+{
+	~KernelCountersRegistry()
+	{
+		for (int i = 0; i < registry.GetCount(); i++)
+		{
+			delete registry[i];
+		}
+		registry.Clear();
+	}
+};
+
+static KernelCountersRegistry registryOwner;
+
+const char* GetKernelName(int kernel)
+{
+	return kernelNames[kernel];
+}
+
+#ifdef LAB6_INSTRUMENTATION
+
+KernelCounters* GetThreadKernelCounters()
+{
+	thread_local KernelCounters* counters = NULL;
+	if (counters == NULL)
+	{
+		counters = new KernelCounters();
+		memset(counters, 0, sizeof(KernelCounters));
+		std::lock_guard<std::mutex> lock(registryMutex);
+		registry.Add(counters);
+	}
+
+	return counters;
+}
+
+KernelScope::KernelScope(int kernel, long long limbs)
+{
+	KernelCounters* counters = GetThreadKernelCounters();
+	counters->calls[kernel]++;
+	counters->limbs[kernel] += limbs;
+	_kernel = kernel;
+	_started = GetNanoseconds();
+}
+
+KernelScope::~KernelScope()
+{
+	GetThreadKernelCounters()->nanoseconds[_kernel] += GetNanoseconds() - _started;
+}
+
+#endif
+
+void GetKernelCounters(KernelCounters* counters)
+{
+	memset(counters, 0, sizeof(KernelCounters));
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (int i = 0; i < registry.GetCount(); i++)
+	{
+		for (int kernel = 0; kernel < KERNELS_COUNT; kernel++)
+		{
+			counters->calls[kernel] += registry[i]->calls[kernel];
+			counters->limbs[kernel] += registry[i]->limbs[kernel];
+			counters->nanoseconds[kernel] += registry[i]->nanoseconds[kernel];
+		}
+		counters->allocations += registry[i]->allocations;
+	}
+}
+
+void ResetKernelCounters()
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (int i = 0; i < registry.GetCount(); i++)
+	{
+		memset(registry[i], 0, sizeof(KernelCounters));
+	}
+}
+
+void PrintKernelCountersJson(FILE* file)
+{
+	KernelCounters counters;
+	GetKernelCounters(&counters);
+
+	fprintf(file, "{\"allocations\": %lld", counters.allocations);
+	for (int kernel = 0; kernel < KERNELS_COUNT; kernel++)
+	{
+		if (counters.calls[kernel] != 0)
+		{
+			fprintf(file, ", \"%s\": {\"calls\": %lld, \"limbs\": %lld, \"ns\": %lld}",
+				kernelNames[kernel], counters.calls[kernel], counters.limbs[kernel], counters.nanoseconds[kernel]);
+		}
+	}
+	fprintf(file, "}");
+}
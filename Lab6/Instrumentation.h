@@ -0,0 +1,65 @@
+#ifndef H_INSTRUMENTATION
+#define H_INSTRUMENTATION
+
+#include <stdio.h>
+
+// Счетчики ядер BigInt: вызовы, обработанные "цифры", время (включая вложенные ядра) и выделения BigInt.
+// Собираются только при сборке с LAB6_INSTRUMENTATION, иначе макросы ничего не делают.
+enum Kernel
+{
+	KERNEL_ADD,
+	KERNEL_SUBTRACT,
+	KERNEL_MULTIPLY,
+	KERNEL_MULTIPLY_SHORT,
+	KERNEL_DIVIDE,
+	KERNEL_DIVIDE_SHORT,
+	KERNEL_POWER,
+	KERNEL_SQUARE_ROOT,
+	KERNEL_ROOT,
+	KERNEL_GCD,
+	KERNEL_COMPARE,
+	KERNEL_PARSE,
+	KERNEL_PRINT,
+	KERNEL_FIXED,
+	KERNELS_COUNT
+};
+
+struct KernelCounters
+{
+	long long calls[KERNELS_COUNT];
+	long long limbs[KERNELS_COUNT];
+	long long nanoseconds[KERNELS_COUNT];
+	long long allocations;
+};
+
+const char* GetKernelName(int kernel);
+void GetKernelCounters(KernelCounters* counters);
+void ResetKernelCounters();
+void PrintKernelCountersJson(FILE* file);
+
+#ifdef LAB6_INSTRUMENTATION
+
+KernelCounters* GetThreadKernelCounters();
+
+class KernelScope
+{
+public:
+	KernelScope(int kernel, long long limbs);
+	~KernelScope();
+
+private:
+	int _kernel;
+	long long _started;
+};
+
+#define INSTRUMENT_KERNEL(kernel, limbs) KernelScope kernelScope(kernel, limbs)
+#define INSTRUMENT_ALLOCATION() (GetThreadKernelCounters()->allocations++)
+
+#else
+
+#define INSTRUMENT_KERNEL(kernel, limbs)
+#define INSTRUMENT_ALLOCATION()
+
+#endif
+
+#endif
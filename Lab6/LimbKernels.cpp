@@ -0,0 +1,363 @@
+#include "LimbKernels.h"
+#include "BigInt.h"
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LAB6_AVX2
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define LAB6_AVX2
+#define TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+//Скалярные циклы без ветвлений: перенос считается сравнением, а не условным переходом
+static int AddLimbsFrom(int* result, const int* left, const int* right, int start, int count, int carry)
+{
+	for (int i = start; i < count; i++)
+	{
+		int sum = left[i] + right[i] + carry;
+		carry = sum >= BigInt::base ? 1 : 0;
+		result[i] = sum - carry * BigInt::base;
+	}
+
+	return carry;
+}
+
+static int SubtractLimbsFrom(int* result, const int* left, const int* right, int start, int count, int borrow)
+{
+	for (int i = start; i < count; i++)
+	{
+		int subtraction = left[i] - right[i] - borrow;
+		borrow = subtraction < 0 ? 1 : 0;
+		result[i] = subtraction + borrow * BigInt::base;
+	}
+
+	return borrow;
+}
+
+int AddLimbsScalar(int* result, const int* left, const int* right, int count)
+{
+	return AddLimbsFrom(result, left, right, 0, count, 0);
+}
+
+int SubtractLimbsScalar(int* result, const int* left, const int* right, int count)
+{
+	return SubtractLimbsFrom(result, left, right, 0, count, 0);
+}
+
+int PropagateCarry(int* result, const int* left, int count, int carry)
+{
+	int i = 0;
+	for (; i < count && carry != 0; i++)
+	{
+		int sum = left[i] + carry;
+		carry = sum == BigInt::base ? 1 : 0;
+		result[i] = sum - carry * BigInt::base;
+	}
+
+	//Дальше перенос не идет: остаток просто копируется
+	if (result != left && i < count)
+	{
+		memcpy(result + i, left + i, (count - i) * sizeof(int));
+	}
+
+	return carry;
+}
+
+int PropagateBorrow(int* result, const int* left, int count, int borrow)
+{
+	int i = 0;
+	for (; i < count && borrow != 0; i++)
+	{
+		int subtraction = left[i] - borrow;
+		borrow = subtraction < 0 ? 1 : 0;
+		result[i] = subtraction + borrow * BigInt::base;
+	}
+
+	if (result != left && i < count)
+	{
+		memcpy(result + i, left + i, (count - i) * sizeof(int));
+	}
+
+	return borrow;
+}
+
+//x / base для x < 2^31 без деления: (x * ceil(2^45 / base)) >> 45.
+//Ошибка округления меньше x / 2^45, то есть меньше 1 / base, и на целую часть не влияет
+static const unsigned long long baseReciprocal = ((1ULL << 45) + BigInt::base - 1) / BigInt::base;
+static const int baseReciprocalShift = 45;
+
+static inline unsigned int DivideByBase(unsigned int value)
+{
+	return (unsigned int)((value * baseReciprocal) >> baseReciprocalShift);
+}
+
+//1, если value >= bound: знаковый бит разности вместо сравнения, которое компилятор превращает в переход
+static inline unsigned int IsAtLeast(unsigned int value, unsigned int bound)
+{
+	return (bound - 1 - value) >> 31;
+}
+
+int MultiplyLimbsByDivision(int* result, const int* left, int count, int right)
+{
+	int carry = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int mult = left[i] * right + carry;
+		carry = mult / BigInt::base;
+		result[i] = mult - carry * BigInt::base;
+	}
+
+	return carry;
+}
+
+//Произведение каждой "цифры" раскладывается на младшую и старшую части независимо от соседних,
+//поэтому умножения идут конвейером; последовательной остается только цепочка переноса 0/1
+int MultiplyLimbsScalar(int* result, const int* left, int count, int right)
+{
+	unsigned int high = 0;
+	unsigned int carry = 0;
+	for (int i = 0; i < count; i++)
+	{
+		unsigned int product = (unsigned int)left[i] * (unsigned int)right;
+		unsigned int productHigh = DivideByBase(product);
+		unsigned int sum = product - productHigh * BigInt::base + high + carry;
+		carry = IsAtLeast(sum, BigInt::base);
+		result[i] = (int)(sum - carry * BigInt::base);
+		high = productHigh;
+	}
+
+	return (int)(high + carry);
+}
+
+int MultiplyAddLimbsScalar(int* result, const int* left, int count, int right)
+{
+	unsigned int high = 0;
+	unsigned int carry = 0;
+	for (int i = 0; i < count; i++)
+	{
+		unsigned int product = (unsigned int)left[i] * (unsigned int)right;
+		unsigned int productHigh = DivideByBase(product);
+		unsigned int sum = product - productHigh * BigInt::base + high + carry + (unsigned int)result[i];
+		carry = IsAtLeast(sum, BigInt::base) + IsAtLeast(sum, 2 * BigInt::base);
+		result[i] = (int)(sum - carry * BigInt::base);
+		high = productHigh;
+	}
+
+	return (int)(high + carry);
+}
+
+#ifdef LAB6_AVX2
+
+//Восемь "цифр" складываются сразу. Разряд порождает перенос (g), если сумма >= base,
+//и пропускает его (p), если сумма равна base - 1. Переносы во все разряды дает одно сложение
+//битовых масок, как в сумматоре: c = ((g | p) + g + cin) ^ p, бит 8 - перенос из блока
+TARGET_AVX2 static int AddLimbsAvx2(int* result, const int* left, const int* right, int count)
+{
+	const __m256i base = _mm256_set1_epi32(BigInt::base);
+	const __m256i maxDigit = _mm256_set1_epi32(BigInt::base - 1);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	unsigned int carry = 0;
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(left + i)), _mm256_loadu_si256((const __m256i*)(right + i)));
+		unsigned int generate = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(sum, maxDigit)));
+		unsigned int propagate = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(sum, maxDigit)));
+		unsigned int carries = (generate | propagate) + generate + carry;
+		carry = carries >> 8;
+		carries ^= propagate;
+
+		__m256i carryIn = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)carries), lanes), one);
+		sum = _mm256_add_epi32(sum, carryIn);
+		sum = _mm256_sub_epi32(sum, _mm256_and_si256(_mm256_cmpgt_epi32(sum, maxDigit), base));
+		_mm256_storeu_si256((__m256i*)(result + i), sum);
+	}
+
+	return AddLimbsFrom(result, left, right, i, count, (int)carry);
+}
+
+//То же для вычитания: заем порождает отрицательная разность, пропускает нулевая
+TARGET_AVX2 static int SubtractLimbsAvx2(int* result, const int* left, const int* right, int count)
+{
+	const __m256i base = _mm256_set1_epi32(BigInt::base);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	unsigned int borrow = 0;
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i difference = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(left + i)), _mm256_loadu_si256((const __m256i*)(right + i)));
+		unsigned int generate = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(difference));
+		unsigned int propagate = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(difference, zero)));
+		unsigned int borrows = (generate | propagate) + generate + borrow;
+		borrow = borrows >> 8;
+		borrows ^= propagate;
+
+		__m256i borrowIn = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)borrows), lanes), one);
+		difference = _mm256_sub_epi32(difference, borrowIn);
+		difference = _mm256_add_epi32(difference, _mm256_and_si256(_mm256_cmpgt_epi32(zero, difference), base));
+		_mm256_storeu_si256((__m256i*)(result + i), difference);
+	}
+
+	return SubtractLimbsFrom(result, left, right, i, count, (int)borrow);
+}
+
+//Блок из восьми произведений: x * right = low + high * base считается по каждой "цифре" независимо
+//(64-битные произведения на обратную величину в четных и нечетных дорожках), high уходит в соседнюю
+//дорожку. Сумма low + high (+ result) < 3 * base нормализуется дважды: сначала без учета соседей
+//(излишек 0..2 тоже сдвигается на дорожку), затем остается перенос 0/1, который разрешается масками, как в сложении
+TARGET_AVX2 static inline __m256i MultiplyBlockAvx2(__m256i digits, __m256i addend, __m256i right,
+	__m256i* previousHigh, __m256i* previousOverflow, unsigned int* carry)
+{
+	const __m256i base = _mm256_set1_epi32(BigInt::base);
+	const __m256i maxDigit = _mm256_set1_epi32(BigInt::base - 1);
+	const __m256i maxDoubleDigit = _mm256_set1_epi32(2 * BigInt::base - 1);
+	const __m256i reciprocal = _mm256_set1_epi64x((long long)baseReciprocal);
+	const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	__m256i product = _mm256_mullo_epi32(digits, right);
+	__m256i evenHigh = _mm256_srli_epi64(_mm256_mul_epu32(product, reciprocal), baseReciprocalShift);
+	__m256i oddHigh = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(product, 32), reciprocal), baseReciprocalShift);
+	__m256i high = _mm256_or_si256(evenHigh, _mm256_slli_epi64(oddHigh, 32));
+	__m256i low = _mm256_sub_epi32(product, _mm256_mullo_epi32(high, base));
+
+	__m256i rotatedHigh = _mm256_permutevar8x32_epi32(high, rotate);
+	__m256i sum = _mm256_add_epi32(_mm256_add_epi32(low, addend), _mm256_blend_epi32(rotatedHigh, *previousHigh, 1));
+	*previousHigh = rotatedHigh;
+
+	__m256i overBase = _mm256_cmpgt_epi32(sum, maxDigit);
+	__m256i overDoubleBase = _mm256_cmpgt_epi32(sum, maxDoubleDigit);
+	sum = _mm256_sub_epi32(sum, _mm256_add_epi32(_mm256_and_si256(overBase, base), _mm256_and_si256(overDoubleBase, base)));
+	__m256i overflow = _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_add_epi32(overBase, overDoubleBase));
+	__m256i rotatedOverflow = _mm256_permutevar8x32_epi32(overflow, rotate);
+	sum = _mm256_add_epi32(sum, _mm256_blend_epi32(rotatedOverflow, *previousOverflow, 1));
+	*previousOverflow = rotatedOverflow;
+
+	unsigned int generate = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(sum, maxDigit)));
+	unsigned int propagate = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(sum, maxDigit)));
+	unsigned int carries = (generate | propagate) + generate + *carry;
+	*carry = carries >> 8;
+	carries ^= propagate;
+
+	sum = _mm256_add_epi32(sum, _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)carries), lanes), one));
+	return _mm256_sub_epi32(sum, _mm256_and_si256(_mm256_cmpgt_epi32(sum, maxDigit), base));
+}
+
+TARGET_AVX2 static int MultiplyLimbsAvx2(int* result, const int* left, int count, int right, bool accumulate)
+{
+	const __m256i multiplier = _mm256_set1_epi32(right);
+	__m256i previousHigh = _mm256_setzero_si256();
+	__m256i previousOverflow = _mm256_setzero_si256();
+	unsigned int carry = 0;
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i addend = accumulate ? _mm256_loadu_si256((const __m256i*)(result + i)) : _mm256_setzero_si256();
+		__m256i digits = MultiplyBlockAvx2(_mm256_loadu_si256((const __m256i*)(left + i)), addend, multiplier,
+			&previousHigh, &previousOverflow, &carry);
+		_mm256_storeu_si256((__m256i*)(result + i), digits);
+	}
+
+	int rest = count - i;
+	if (rest == 0)
+	{
+		//В нулевой дорожке повернутых векторов - старшая часть и излишек последней "цифры"
+		return _mm256_cvtsi256_si32(previousHigh) + _mm256_cvtsi256_si32(previousOverflow) + (int)carry;
+	}
+
+	//Хвост читается маской (за концом нули); перенос оказывается в первой дорожке за концом
+	__m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(rest), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	__m256i addend = accumulate ? _mm256_maskload_epi32(result + i, mask) : _mm256_setzero_si256();
+	__m256i digits = MultiplyBlockAvx2(_mm256_maskload_epi32(left + i, mask), addend, multiplier,
+		&previousHigh, &previousOverflow, &carry);
+	_mm256_maskstore_epi32(result + i, mask, digits);
+
+	return _mm256_cvtsi256_si32(_mm256_permutevar8x32_epi32(digits, _mm256_set1_epi32(rest)));
+}
+
+static bool DetectAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const bool hasAvx2 = DetectAvx2();
+
+bool HasSimdLimbKernels()
+{
+	return hasAvx2;
+}
+
+int AddLimbs(int* result, const int* left, const int* right, int count)
+{
+	return hasAvx2 ? AddLimbsAvx2(result, left, right, count) : AddLimbsScalar(result, left, right, count);
+}
+
+int SubtractLimbs(int* result, const int* left, const int* right, int count)
+{
+	return hasAvx2 ? SubtractLimbsAvx2(result, left, right, count) : SubtractLimbsScalar(result, left, right, count);
+}
+
+//Короче блока маскированные загрузки дороже скалярного цикла
+int MultiplyLimbs(int* result, const int* left, int count, int right)
+{
+	return hasAvx2 && count >= 8 ? MultiplyLimbsAvx2(result, left, count, right, false) : MultiplyLimbsScalar(result, left, count, right);
+}
+
+int MultiplyAddLimbs(int* result, const int* left, int count, int right)
+{
+	return hasAvx2 && count >= 8 ? MultiplyLimbsAvx2(result, left, count, right, true) : MultiplyAddLimbsScalar(result, left, count, right);
+}
+
+#else
+
+bool HasSimdLimbKernels()
+{
+	return false;
+}
+
+int AddLimbs(int* result, const int* left, const int* right, int count)
+{
+	return AddLimbsScalar(result, left, right, count);
+}
+
+int SubtractLimbs(int* result, const int* left, const int* right, int count)
+{
+	return SubtractLimbsScalar(result, left, right, count);
+}
+
+int MultiplyLimbs(int* result, const int* left, int count, int right)
+{
+	return MultiplyLimbsScalar(result, left, count, right);
+}
+
+int MultiplyAddLimbs(int* result, const int* left, int count, int right)
+{
+	return MultiplyAddLimbsScalar(result, left, count, right);
+}
+
+#endif
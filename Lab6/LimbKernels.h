@@ -0,0 +1,27 @@
+#ifndef H_LIMB_KERNELS
+#define H_LIMB_KERNELS
+
+// Сложение и вычитание массивов "цифр" одной длины с переносом.
+// AddLimbs/SubtractLimbs выбирают AVX2-вариант, если процессор его поддерживает, иначе скалярный.
+// result может совпадать с left: каждая "цифра" читается до записи.
+int AddLimbs(int* result, const int* left, const int* right, int count);
+int SubtractLimbs(int* result, const int* left, const int* right, int count);
+int AddLimbsScalar(int* result, const int* left, const int* right, int count);
+int SubtractLimbsScalar(int* result, const int* left, const int* right, int count);
+
+// Перенос (заем) через оставшиеся "цифры" более длинного операнда.
+int PropagateCarry(int* result, const int* left, int count, int carry);
+int PropagateBorrow(int* result, const int* left, int count, int borrow);
+
+// Умножение массива "цифр" на короткое 0 <= right <= base без деления, возвращает перенос (< base).
+// MultiplyAddLimbs прибавляет произведение к result (right < base).
+// MultiplyLimbsByDivision - прежний вариант с делением на каждой "цифре", для произвольного right.
+int MultiplyLimbs(int* result, const int* left, int count, int right);
+int MultiplyAddLimbs(int* result, const int* left, int count, int right);
+int MultiplyLimbsScalar(int* result, const int* left, int count, int right);
+int MultiplyAddLimbsScalar(int* result, const int* left, int count, int right);
+int MultiplyLimbsByDivision(int* result, const int* left, int count, int right);
+
+bool HasSimdLimbKernels();
+
+#endif
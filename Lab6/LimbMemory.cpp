@@ -0,0 +1,158 @@
+#include "LimbMemory.h"
+#include "BigInt.h"
+#include "Numa.h"
+#include <new>
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <mutex>
+#include <atomic>
+
+static const size_t hugePageLength = 2 << 20;
+static const size_t chunkLength = 4 * hugePageLength;
+//Адреса под все куски занимаются сразу (без памяти): принадлежность слота проверяется по диапазону
+static const size_t reservedLength = (size_t)1 << 36;
+static const int maxNodesCount = 64;
+
+struct FreeSlot
+{
+	FreeSlot* next;
+};
+
+struct LimbArena
+{
+	char* start;
+	size_t slotLength;
+	std::atomic<size_t> used;
+	unsigned char chunkNodes[reservedLength / chunkLength];
+	std::mutex mutexes[maxNodesCount];
+	FreeSlot* freeSlots[maxNodesCount];
+};
+
+static HugePages hugePages = HUGE_PAGES_NONE;
+static std::atomic<LimbArena*> arena(NULL);
+
+static LimbArena* CreateArena()
+{
+	void* reserved = mmap(NULL, reservedLength + hugePageLength, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (reserved == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	LimbArena* created = new LimbArena();
+	created->start = (char*)(((size_t)reserved + hugePageLength - 1) & ~(hugePageLength - 1));
+	created->slotLength = (sizeof(BigInt) + 63) & ~(size_t)63;
+	created->used = 0;
+	for (int i = 0; i < maxNodesCount; i++)
+	{
+		created->freeSlots[i] = NULL;
+	}
+
+	return created;
+}
+
+void SetHugePages(HugePages mode)
+{
+	static std::mutex creation;
+	std::lock_guard<std::mutex> lock(creation);
+	if (mode != HUGE_PAGES_NONE && arena == NULL)
+	{
+		arena = CreateArena();
+	}
+
+	hugePages = mode;
+}
+
+//Кусок режется на слоты под замком узла; запись ссылок касается страниц уже с потока этого узла
+static bool AddChunk(LimbArena* current, int node)
+{
+	size_t offset = current->used.fetch_add(chunkLength);
+	if (offset + chunkLength > reservedLength)
+	{
+		return false;
+	}
+
+	char* chunk = current->start + offset;
+	bool mapped = hugePages == HUGE_PAGES_EXPLICIT
+		&& mmap(chunk, chunkLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0) != MAP_FAILED;
+	if (!mapped)
+	{
+		if (mprotect(chunk, chunkLength, PROT_READ | PROT_WRITE) != 0)
+		{
+			return false;
+		}
+		madvise(chunk, chunkLength, MADV_HUGEPAGE);
+	}
+
+	BindToNumaNode(chunk, chunkLength, node);
+	current->chunkNodes[offset / chunkLength] = (unsigned char)node;
+	for (size_t slot = 0; slot + current->slotLength <= chunkLength; slot += current->slotLength)
+	{
+		FreeSlot* freeSlot = (FreeSlot*)(chunk + slot);
+		freeSlot->next = current->freeSlots[node];
+		current->freeSlots[node] = freeSlot;
+	}
+
+	return true;
+}
+
+void* AllocateLimbs(size_t size)
+{
+	LimbArena* current = arena;
+	if (hugePages == HUGE_PAGES_NONE || current == NULL || size < limbArenaThreshold || size > current->slotLength)
+	{
+		return ::operator new(size);
+	}
+
+	int node = GetCurrentNumaNode() % maxNodesCount;
+	{
+		std::lock_guard<std::mutex> lock(current->mutexes[node]);
+		if (current->freeSlots[node] != NULL || AddChunk(current, node))
+		{
+			FreeSlot* slot = current->freeSlots[node];
+			current->freeSlots[node] = slot->next;
+			return slot;
+		}
+	}
+
+	//Зарезервированные адреса кончились: дальше обычная куча
+	return ::operator new(size);
+}
+
+void FreeLimbs(void* memory)
+{
+	LimbArena* current = arena;
+	char* address = (char*)memory;
+	if (current == NULL || address < current->start || address >= current->start + reservedLength)
+	{
+		::operator delete(memory);
+		return;
+	}
+
+	//Слот возвращается узлу своего куска, даже если освобождает поток другого узла
+	int node = current->chunkNodes[(address - current->start) / chunkLength];
+	std::lock_guard<std::mutex> lock(current->mutexes[node]);
+	FreeSlot* slot = (FreeSlot*)memory;
+	slot->next = current->freeSlots[node];
+	current->freeSlots[node] = slot;
+}
+
+#else
+
+void SetHugePages(HugePages mode)
+{
+}
+
+void* AllocateLimbs(size_t size)
+{
+	return ::operator new(size);
+}
+
+void FreeLimbs(void* memory)
+{
+	::operator delete(memory);
+}
+
+#endif
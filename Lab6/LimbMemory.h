@@ -0,0 +1,21 @@
+#ifndef H_LIMB_MEMORY
+#define H_LIMB_MEMORY
+
+#include <stddef.h>
+
+enum HugePages {HUGE_PAGES_NONE, HUGE_PAGES_TRANSPARENT, HUGE_PAGES_EXPLICIT};
+
+// Память под "цифры" чисел (BigInt - 200 КБ). По умолчанию - обычная куча.
+// С огромными страницами выделения от limbArenaThreshold байт берутся слотами из кусков по 8 МБ (Linux):
+// кусок отображается явными огромными страницами (MAP_HUGETLB), а если их не выделено - прозрачными
+// (madvise), и привязывается к узлу NUMA потока, который его запросил. Число тогда лежит в одной-двух
+// страницах TLB вместо пятидесяти, а поток получает числа со своего узла. Свободные слоты хранятся по узлам
+// и системе не возвращаются; память, выделенная до переключения режима, освобождается туда, откуда взята.
+// Режим переключается до вычислений, не параллельно с ними.
+static const size_t limbArenaThreshold = 65536;
+
+void SetHugePages(HugePages mode);
+void* AllocateLimbs(size_t size);
+void FreeLimbs(void* memory);
+
+#endif
@@ -0,0 +1,180 @@
+#include "Numa.h"
+
+#ifdef __linux__
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+static const int maxNodesCount = 64;
+//Память с предпочтительного узла, а если там кончилась - с любого (MPOL_PREFERRED из linux/mempolicy.h)
+static const int preferredMemoryPolicy = 1;
+
+struct NumaTopology
+{
+	int nodesCount;
+	unsigned char cpuNodes[CPU_SETSIZE];
+};
+
+//Список процессоров вида "0-3,8-11" переводится в маску
+static bool ReadNodeCpus(int node, cpu_set_t* cpus)
+{
+	char name[64];
+	sprintf(name, "/sys/devices/system/node/node%d/cpulist", node);
+	FILE* file = fopen(name, "r");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	CPU_ZERO(cpus);
+	int first = 0;
+	while (fscanf(file, "%d", &first) == 1)
+	{
+		int last = first;
+		int separator = fgetc(file);
+		if (separator == '-')
+		{
+			if (fscanf(file, "%d", &last) != 1)
+			{
+				break;
+			}
+			separator = fgetc(file);
+		}
+
+		for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+		{
+			CPU_SET(cpu, cpus);
+		}
+
+		if (separator != ',')
+		{
+			break;
+		}
+	}
+
+	fclose(file);
+	return CPU_COUNT(cpus) > 0;
+}
+
+static NumaTopology* ReadTopology()
+{
+	NumaTopology* topology = new NumaTopology();
+	memset(topology->cpuNodes, 0, sizeof(topology->cpuNodes));
+	topology->nodesCount = 0;
+
+	cpu_set_t cpus;
+	while (topology->nodesCount < maxNodesCount && ReadNodeCpus(topology->nodesCount, &cpus))
+	{
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if (CPU_ISSET(cpu, &cpus))
+			{
+				topology->cpuNodes[cpu] = (unsigned char)topology->nodesCount;
+			}
+		}
+		topology->nodesCount++;
+	}
+
+	if (topology->nodesCount == 0)
+	{
+		topology->nodesCount = 1;
+	}
+
+	return topology;
+}
+
+//sysfs читается один раз на процесс
+static const NumaTopology* GetTopology()
+{
+	static NumaTopology* topology = ReadTopology();
+	return topology;
+}
+
+int GetNumaNodesCount()
+{
+	return GetTopology()->nodesCount;
+}
+
+int GetCurrentNumaNode()
+{
+	int cpu = sched_getcpu();
+	return cpu >= 0 && cpu < CPU_SETSIZE ? GetTopology()->cpuNodes[cpu] : 0;
+}
+
+bool PinToNumaNode(int node)
+{
+	cpu_set_t cpus;
+	if (!ReadNodeCpus(node, &cpus) || sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+	{
+		return false;
+	}
+
+	//Политика памяти - только совет: без поддержки в ядре хватает и "первого касания" с закрепленного потока
+	unsigned long nodes = 1UL << node;
+	syscall(SYS_set_mempolicy, preferredMemoryPolicy, &nodes, (unsigned long)maxNodesCount + 1);
+	return true;
+}
+
+//Процессор выбирается из тех, что разрешены потоку сейчас: внутри процесса, закрепленного за узлом, - из узла
+bool PinToCpu(int index)
+{
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0)
+	{
+		return false;
+	}
+
+	int skip = index % CPU_COUNT(&allowed);
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (CPU_ISSET(cpu, &allowed) && skip-- == 0)
+		{
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(cpu, &cpus);
+			return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+		}
+	}
+
+	return false;
+}
+
+void BindToNumaNode(void* memory, size_t length, int node)
+{
+	if (GetNumaNodesCount() > 1)
+	{
+		unsigned long nodes = 1UL << node;
+		syscall(SYS_mbind, memory, length, preferredMemoryPolicy, &nodes, (unsigned long)maxNodesCount + 1, 0);
+	}
+}
+
+#else
+
+int GetNumaNodesCount()
+{
+	return 1;
+}
+
+int GetCurrentNumaNode()
+{
+	return 0;
+}
+
+bool PinToNumaNode(int node)
+{
+	return false;
+}
+
+bool PinToCpu(int index)
+{
+	return false;
+}
+
+void BindToNumaNode(void* memory, size_t length, int node)
+{
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef H_NUMA
+#define H_NUMA
+
+#include <stddef.h>
+
+// Узлы NUMA по sysfs (/sys/devices/system/node/nodeN/cpulist), без libnuma.
+// Если sysfs нет (не Linux, контейнер без него), узел считается один и закрепление ничего не делает.
+int GetNumaNodesCount();
+int GetCurrentNumaNode();
+
+// Закрепляет вызывающий поток за процессорами узла (потоки, созданные после, наследуют это)
+// и просит ядро брать память для него с того же узла.
+bool PinToNumaNode(int node);
+
+// Закрепляет вызывающий поток за одним процессором: index-м по кругу из разрешенных ему сейчас.
+bool PinToCpu(int index);
+
+// Страницы памяти, которых еще не касались, ядро будет брать с узла node.
+void BindToNumaNode(void* memory, size_t length, int node);
+
+#endif
@@ -0,0 +1,276 @@
+#include "PowerCache.h"
+#include "Instrumentation.h"
+
+static int CountBits(int value)
+{
+	int count = 0;
+	for (; value > 0; value &= value - 1)
+	{
+		count++;
+	}
+
+	return count;
+}
+
+PowerCache::PowerCache(size_t maxBytes)
+{
+	_newest = NULL;
+	_oldest = NULL;
+	_maxBytes = maxBytes;
+	_usedBytes = 0;
+	_hits = 0;
+	_reuses = 0;
+	_misses = 0;
+}
+
+PowerCache::~PowerCache()
+{
+	while (_oldest != NULL)
+	{
+		Evict(_oldest);
+	}
+}
+
+BigInt* PowerCache::Power(const BigInt* left, const BigInt* power)
+{
+	//Большие показатели и основания 0 и 1 кэшировать незачем
+	if (power->size > 2 || IsZero(power) || IsZero(left) || (left->size == 1 && left->digits[0] == 1))
+	{
+		return ::Power(left, power);
+	}
+
+	INSTRUMENT_KERNEL(KERNEL_POWER, left->size);
+	int exponent = power->digits[0] + (power->size > 1 ? power->digits[1] * BigInt::base : 0);
+	if (CountPowerLimbsLowerBound(left, exponent) > BigInt::maxDigitsCount + 1)
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	PowerCacheBase* entry = FindBase(left);
+	MoveToFront(entry);
+
+	//Ищем сохраненный результат, от которого до нужной степени меньше всего умножений
+	int start = 0;
+	int cost = CountBits(exponent);
+	bool square = false;
+	BigInt* startDigit = NULL;
+	for (int i = 0; i < entry->resultsCount; i++)
+	{
+		int known = entry->exponents[i];
+		if (known == exponent)
+		{
+			_hits++;
+			return new BigInt(*entry->results[i]);
+		}
+
+		if (known < exponent && CountBits(exponent - known) < cost)
+		{
+			start = known;
+			cost = CountBits(exponent - known);
+			square = false;
+			startDigit = entry->results[i];
+		}
+
+		if (known * 2 == exponent && cost > 1)
+		{
+			start = known;
+			cost = 1;
+			square = true;
+			startDigit = entry->results[i];
+		}
+	}
+
+	BigInt* result = NULL;
+	try
+	{
+		if (square)
+		{
+			result = Multiply(startDigit, startDigit);
+		}
+		else
+		{
+			result = startDigit != NULL ? new BigInt(*startDigit) : new BigInt(1);
+			int rest = exponent - start;
+			for (int k = 0; rest > 0; k++, rest >>= 1)
+			{
+				if (rest & 1)
+				{
+					BigInt* oldResult = result;
+					result = Multiply(result, GetSquare(entry, k));
+					delete oldResult;
+				}
+			}
+		}
+	}
+	catch (AppException)
+	{
+		//Квадраты, досчитанные до ошибки, остаются в кэше: его размер держим и здесь
+		delete result;
+		Trim();
+		throw;
+	}
+
+	if (startDigit != NULL)
+	{
+		_reuses++;
+	}
+	else
+	{
+		_misses++;
+	}
+
+	Remember(entry, exponent, result);
+	Trim();
+
+	return result;
+}
+
+PowerCacheBase* PowerCache::FindBase(const BigInt* left)
+{
+	for (PowerCacheBase* entry = _newest; entry != NULL; entry = entry->older)
+	{
+		if (AreEquals(entry->base, left))
+		{
+			return entry;
+		}
+	}
+
+	PowerCacheBase* entry = new PowerCacheBase();
+	entry->base = new BigInt(*left);
+	entry->squaresCount = 0;
+	entry->resultsCount = 0;
+	entry->nextResult = 0;
+	entry->newer = NULL;
+	entry->older = NULL;
+	_usedBytes += sizeof(BigInt);
+
+	return entry;
+}
+
+//b^(2^k), досчитывая недостающие возведения в квадрат
+const BigInt* PowerCache::GetSquare(PowerCacheBase* entry, int k)
+{
+	if (entry->squaresCount == 0)
+	{
+		entry->squares[0] = new BigInt(*entry->base);
+		entry->squaresCount = 1;
+		_usedBytes += sizeof(BigInt);
+	}
+
+	while (entry->squaresCount <= k)
+	{
+		const BigInt* last = entry->squares[entry->squaresCount - 1];
+		entry->squares[entry->squaresCount] = Multiply(last, last);
+		entry->squaresCount++;
+		_usedBytes += sizeof(BigInt);
+	}
+
+	return entry->squares[k];
+}
+
+void PowerCache::Remember(PowerCacheBase* entry, int exponent, const BigInt* result)
+{
+	int index = entry->nextResult;
+	if (index < entry->resultsCount)
+	{
+		delete entry->results[index];
+	}
+	else
+	{
+		entry->resultsCount++;
+		_usedBytes += sizeof(BigInt);
+	}
+
+	entry->exponents[index] = exponent;
+	entry->results[index] = new BigInt(*result);
+	entry->nextResult = (index + 1) % PowerCacheBase::recentResultsCount;
+}
+
+void PowerCache::Unlink(PowerCacheBase* entry)
+{
+	if (entry->newer != NULL)
+	{
+		entry->newer->older = entry->older;
+	}
+	else if (_newest == entry)
+	{
+		_newest = entry->older;
+	}
+
+	if (entry->older != NULL)
+	{
+		entry->older->newer = entry->newer;
+	}
+	else if (_oldest == entry)
+	{
+		_oldest = entry->newer;
+	}
+
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+void PowerCache::MoveToFront(PowerCacheBase* entry)
+{
+	Unlink(entry);
+
+	entry->older = _newest;
+	if (_newest != NULL)
+	{
+		_newest->newer = entry;
+	}
+	_newest = entry;
+
+	if (_oldest == NULL)
+	{
+		_oldest = entry;
+	}
+}
+
+void PowerCache::Evict(PowerCacheBase* entry)
+{
+	Unlink(entry);
+
+	for (int i = 0; i < entry->squaresCount; i++)
+	{
+		delete entry->squares[i];
+	}
+
+	for (int i = 0; i < entry->resultsCount; i++)
+	{
+		delete entry->results[i];
+	}
+
+	delete entry->base;
+	_usedBytes -= (1 + entry->squaresCount + entry->resultsCount) * sizeof(BigInt);
+	delete entry;
+}
+
+//Вытесняем основания, которые давно не использовались
+void PowerCache::Trim()
+{
+	while (_usedBytes > _maxBytes && _oldest != NULL)
+	{
+		Evict(_oldest);
+	}
+}
+
+int PowerCache::GetHits()
+{
+	return _hits;
+}
+
+int PowerCache::GetReuses()
+{
+	return _reuses;
+}
+
+int PowerCache::GetMisses()
+{
+	return _misses;
+}
+
+size_t PowerCache::GetUsedBytes()
+{
+	return _usedBytes;
+}
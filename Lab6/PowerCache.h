@@ -0,0 +1,53 @@
+#ifndef H_POWER_CACHE
+#define H_POWER_CACHE
+
+#include "BigInt.h"
+
+struct PowerCacheBase
+{
+	static const int maxSquares = 31;
+	static const int recentResultsCount = 4;
+
+	BigInt* base;
+	BigInt* squares[maxSquares];
+	int squaresCount;
+	int exponents[recentResultsCount];
+	BigInt* results[recentResultsCount];
+	int resultsCount;
+	int nextResult;
+	PowerCacheBase* newer;
+	PowerCacheBase* older;
+};
+
+// Степени основания вида b^(2^k) и последние результаты b^e для повторных строк '^' с тем же основанием.
+class PowerCache
+{
+public:
+	PowerCache(size_t maxBytes);
+	~PowerCache();
+
+	BigInt* Power(const BigInt* left, const BigInt* power);
+	int GetHits();
+	int GetReuses();
+	int GetMisses();
+	size_t GetUsedBytes();
+
+private:
+	PowerCacheBase* FindBase(const BigInt* left);
+	const BigInt* GetSquare(PowerCacheBase* entry, int k);
+	void Remember(PowerCacheBase* entry, int exponent, const BigInt* result);
+	void MoveToFront(PowerCacheBase* entry);
+	void Unlink(PowerCacheBase* entry);
+	void Evict(PowerCacheBase* entry);
+	void Trim();
+
+	PowerCacheBase* _newest;
+	PowerCacheBase* _oldest;
+	size_t _maxBytes;
+	size_t _usedBytes;
+	int _hits;
+	int _reuses;
+	int _misses;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "PreparedDivisor.h"
+#include "Instrumentation.h"
+#include "LimbKernels.h"
+#include <string.h>
+
+static const int inverseShift = 48;
+
+PreparedDivisor::PreparedDivisor(const BigInt* divisor)
+{
+	if (IsZero(divisor))
+	{
+		throw AppException(ErrorMessages::ERROR);
+	}
+
+	_size = divisor->size;
+	_divisor = (int*) malloc(_size * sizeof(int));
+	_normalized = (int*) malloc(_size * sizeof(int));
+	if (_divisor == NULL || _normalized == NULL)
+	{
+		free(_divisor);
+		free(_normalized);
+		throw AppException(ErrorMessages::MEMORY_ERROR);
+	}
+	memcpy(_divisor, divisor->digits, _size * sizeof(int));
+
+	//Умножаем делитель так, чтобы старшая "цифра" была не меньше половины основания
+	_factor = BigInt::base / (divisor->digits[_size - 1] + 1);
+	MultiplyLimbs(_normalized, divisor->digits, _size, _factor);
+
+	//Обратное к старшей "цифре": частное двух "цифр" на нее считается умножением и сдвигом
+	_inverse = ((1ULL << inverseShift) / _normalized[_size - 1]) + 1;
+}
+
+PreparedDivisor::~PreparedDivisor()
+{
+	free(_divisor);
+	free(_normalized);
+}
+
+bool PreparedDivisor::IsFor(const BigInt* divisor) const
+{
+	return divisor->size == _size && memcmp(divisor->digits, _divisor, _size * sizeof(int)) == 0;
+}
+
+int PreparedDivisor::EstimateQuotient(long long numerator) const
+{
+	return (int)(((unsigned long long)numerator * _inverse) >> inverseShift);
+}
+
+BigInt* PreparedDivisor::DivideShort(const BigInt* divident) const
+{
+	BigInt* result = new BigInt(0, divident->size);
+	int divisor = _divisor[0];
+	int remainder = 0;
+	for (int i = divident->size - 1; i >= 0; i--)
+	{
+		int current = remainder * BigInt::base + divident->digits[i];
+		result->digits[i] = current / divisor;
+		remainder = current - result->digits[i] * divisor;
+	}
+
+	result->size = DeleteExtraZeros(divident->size, result);
+	return result;
+}
+
+BigInt* PreparedDivisor::Divide(const BigInt* divident) const
+{
+	INSTRUMENT_KERNEL(KERNEL_DIVIDE, (long long)divident->size * _size);
+	if (divident->size < _size)
+	{
+		return new BigInt(0);
+	}
+
+	if (_size == 1)
+	{
+		return DivideShort(divident);
+	}
+
+	int n = _size;
+	int m = divident->size - n;
+	int* u = (int*) malloc((divident->size + 1) * sizeof(int));
+	if (u == NULL)
+	{
+		throw AppException(ErrorMessages::MEMORY_ERROR);
+	}
+
+	u[divident->size] = MultiplyLimbs(u, divident->digits, divident->size, _factor);
+
+	BigInt* result = new BigInt(0, m + 1);
+	int top = _normalized[n - 1];
+	int second = _normalized[n - 2];
+
+	//Алгоритм D Кнута: оценка "цифры" частного по двум старшим "цифрам", не более двух поправок
+	for (int j = m; j >= 0; j--)
+	{
+		long long numerator = (long long)u[j + n] * BigInt::base + u[j + n - 1];
+		long long quotient = EstimateQuotient(numerator);
+		long long remainder = numerator - quotient * top;
+		while (quotient >= BigInt::base || quotient * second > remainder * BigInt::base + u[j + n - 2])
+		{
+			quotient--;
+			remainder += top;
+			if (remainder >= BigInt::base)
+			{
+				break;
+			}
+		}
+
+		//Вычитаем произведение делителя на оценку
+		long long multCarry = 0;
+		int borrow = 0;
+		for (int i = 0; i < n; i++)
+		{
+			long long mult = quotient * _normalized[i] + multCarry;
+			multCarry = mult / BigInt::base;
+			int subtraction = u[i + j] - (int)(mult - multCarry * BigInt::base) - borrow;
+			borrow = subtraction < 0 ? 1 : 0;
+			u[i + j] = subtraction + borrow * BigInt::base;
+		}
+		int subtraction = u[j + n] - (int)multCarry - borrow;
+		u[j + n] = subtraction;
+
+		//Оценка оказалась на единицу больше: возвращаем делитель
+		if (subtraction < 0)
+		{
+			quotient--;
+			int addCarry = 0;
+			for (int i = 0; i < n; i++)
+			{
+				int sum = u[i + j] + _normalized[i] + addCarry;
+				addCarry = sum >= BigInt::base ? 1 : 0;
+				u[i + j] = sum - addCarry * BigInt::base;
+			}
+			u[j + n] += addCarry;
+		}
+
+		result->digits[j] = (int)quotient;
+	}
+
+	free(u);
+	result->size = DeleteExtraZeros(m + 1, result);
+	return result;
+}
+
+void PreparedDivisor::DivideAll(const BigInt* const* dividents, int count, BigInt** results) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		results[i] = Divide(dividents[i]);
+	}
+}
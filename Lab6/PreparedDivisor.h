@@ -0,0 +1,28 @@
+#ifndef H_PREPARED_DIVISOR
+#define H_PREPARED_DIVISOR
+
+#include "BigInt.h"
+
+// Нормализованный делитель и обратное к его старшей "цифре" для деления многих чисел на одно.
+class PreparedDivisor
+{
+public:
+	PreparedDivisor(const BigInt* divisor);
+	~PreparedDivisor();
+
+	bool IsFor(const BigInt* divisor) const;
+	BigInt* Divide(const BigInt* divident) const;
+	void DivideAll(const BigInt* const* dividents, int count, BigInt** results) const;
+
+private:
+	int EstimateQuotient(long long numerator) const;
+	BigInt* DivideShort(const BigInt* divident) const;
+
+	int _size;
+	int* _divisor;
+	int* _normalized;
+	int _factor;
+	unsigned long long _inverse;
+};
+
+#endif
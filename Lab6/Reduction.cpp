@@ -0,0 +1,180 @@
+#include "Reduction.h"
+#include <string.h>
+#include <stdlib.h>
+
+Reduction::Reduction(int operation)
+{
+	_operation = operation;
+	_columns = NULL;
+	_columnsCount = 0;
+	_subtreesCount = 0;
+	_zero = false;
+	_overflow = false;
+}
+
+Reduction::~Reduction()
+{
+	free(_columns);
+	for (int i = 0; i < _subtreesCount; i++)
+	{
+		delete _subtrees[i];
+	}
+}
+
+//Число переходит свертке: слагаемое удаляется сразу, множитель становится листом дерева
+void Reduction::Add(BigInt* digit)
+{
+	if (_operation != '+')
+	{
+		AddToProduct(digit);
+		return;
+	}
+
+	try
+	{
+		AddToSum(digit);
+	}
+	catch(AppException ex)
+	{
+		delete digit;
+		throw;
+	}
+	delete digit;
+}
+
+//Столбцы растут до длины самого длинного слагаемого; по 9999 в столбец 64 бита хватит на 10^15 слагаемых
+void Reduction::AddToSum(const BigInt* digit)
+{
+	if (digit->size > _columnsCount)
+	{
+		unsigned long long* columns = (unsigned long long*) realloc(_columns, digit->size * sizeof(unsigned long long));
+		if (columns == NULL)
+		{
+			throw AppException(ErrorMessages::MEMORY_ERROR);
+		}
+
+		memset(columns + _columnsCount, 0, (digit->size - _columnsCount) * sizeof(unsigned long long));
+		_columns = columns;
+		_columnsCount = digit->size;
+	}
+
+	for (int i = 0; i < digit->size; i++)
+	{
+		_columns[i] += (unsigned int)digit->digits[i];
+	}
+}
+
+void Reduction::AddToProduct(BigInt* digit)
+{
+	//С нулевым множителем остальные можно не перемножать
+	if (_zero || IsZero(digit))
+	{
+		for (int i = 0; i < _subtreesCount; i++)
+		{
+			delete _subtrees[i];
+		}
+		_subtreesCount = 0;
+		_zero = true;
+		delete digit;
+		return;
+	}
+
+	//После переполнения ждем только нулевой множитель
+	if (_overflow)
+	{
+		delete digit;
+		return;
+	}
+
+	_subtrees[_subtreesCount] = digit;
+	_subtreeSizes[_subtreesCount] = 1;
+	_subtreesCount++;
+
+	//Поддеревья с равным числом множителей сливаются, как разряды счетчика при прибавлении единицы
+	try
+	{
+		while (_subtreesCount >= 2 && _subtreeSizes[_subtreesCount - 1] == _subtreeSizes[_subtreesCount - 2])
+		{
+			MergeSubtrees();
+		}
+	}
+	catch(AppException ex)
+	{
+		if (ex.GetMessage() != ErrorMessages::ERROR)
+		{
+			throw;
+		}
+
+		for (int i = 0; i < _subtreesCount; i++)
+		{
+			delete _subtrees[i];
+		}
+		_subtreesCount = 0;
+		_overflow = true;
+	}
+}
+
+//Два верхних поддерева заменяются произведением; при переполнении оба остаются и удаляются деструктором
+void Reduction::MergeSubtrees()
+{
+	BigInt* left = _subtrees[_subtreesCount - 2];
+	BigInt* right = _subtrees[_subtreesCount - 1];
+	BigInt* product = Multiply(left, right);
+	delete left;
+	delete right;
+
+	_subtreesCount--;
+	_subtrees[_subtreesCount - 1] = product;
+	_subtreeSizes[_subtreesCount - 1] += _subtreeSizes[_subtreesCount];
+}
+
+//Вызывается один раз, после всех операндов
+BigInt* Reduction::GetResult()
+{
+	if (_operation != '+')
+	{
+		if (_overflow && !_zero)
+		{
+			throw AppException(ErrorMessages::ERROR);
+		}
+
+		if (_zero || _subtreesCount == 0)
+		{
+			return new BigInt(_zero ? 0 : 1);
+		}
+
+		while (_subtreesCount > 1)
+		{
+			MergeSubtrees();
+		}
+
+		_subtreesCount = 0;
+		return _subtrees[0];
+	}
+
+	//Единственный проход переносов; перенос из последнего столбца меньше 2^64 / base - до четырех "цифр"
+	BigInt* result = new BigInt(0, _columnsCount + 4);
+	unsigned long long carry = 0;
+	int size = 0;
+	for (; size < _columnsCount; size++)
+	{
+		unsigned long long value = _columns[size] + carry;
+		carry = value / BigInt::base;
+		result->digits[size] = (int)(value - carry * BigInt::base);
+	}
+
+	for (; carry > 0; size++)
+	{
+		if (size == BigInt::maxDigitsCount)
+		{
+			delete result;
+			throw AppException(ErrorMessages::ERROR);
+		}
+
+		result->digits[size] = (int)(carry % BigInt::base);
+		carry /= BigInt::base;
+	}
+
+	result->size = size > 0 ? DeleteExtraZeros(size, result) : 1;
+	return result;
+}
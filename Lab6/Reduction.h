@@ -0,0 +1,38 @@
+#ifndef H_REDUCTION
+#define H_REDUCTION
+
+#include "BigInt.h"
+
+// Свертка операндов по одному: + или *.
+// Сумма копится в 64-битных столбцах без переносов, переносы расставляются один раз в GetResult.
+// Произведение считается деревом, как двоичный счетчик: два поддерева с равным числом множителей сразу
+// перемножаются. В памяти не больше log2(N) промежуточных чисел, а перемножаются числа близкой длины.
+// Переполнение произведения запоминается и бросается только в GetResult, если нулевого множителя так и не было:
+// результат не зависит от порядка операндов.
+class Reduction
+{
+public:
+	static const int maxSubtreesCount = 64;
+
+	Reduction(int operation);
+	~Reduction();
+
+	void Add(BigInt* digit);
+	BigInt* GetResult();
+
+private:
+	void AddToSum(const BigInt* digit);
+	void AddToProduct(BigInt* digit);
+	void MergeSubtrees();
+
+	int _operation;
+	unsigned long long* _columns;
+	int _columnsCount;
+	BigInt* _subtrees[maxSubtreesCount];
+	long long _subtreeSizes[maxSubtreesCount];
+	int _subtreesCount;
+	bool _zero;
+	bool _overflow;
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "ResultCache.h"
+#include <string.h>
+
+ResultCache::ResultCache(size_t maxBytes)
+{
+	for (int i = 0; i < bucketsCount; i++)
+	{
+		_buckets[i] = NULL;
+	}
+
+	_newest = NULL;
+	_oldest = NULL;
+	_maxBytes = maxBytes;
+	_usedBytes = 0;
+	_hits = 0;
+	_misses = 0;
+}
+
+ResultCache::~ResultCache()
+{
+	while (_oldest != NULL)
+	{
+		Evict();
+	}
+}
+
+unsigned int ResultCache::Hash(int operation, const BigInt* first, const BigInt* second)
+{
+	//FNV-1a по операции, размерам и "цифрам" операндов
+	unsigned int hash = 2166136261u;
+	hash = (hash ^ (unsigned int)operation) * 16777619u;
+	hash = (hash ^ (unsigned int)first->size) * 16777619u;
+	for (int i = 0; i < first->size; i++)
+	{
+		hash = (hash ^ (unsigned int)first->digits[i]) * 16777619u;
+	}
+
+	hash = (hash ^ (unsigned int)second->size) * 16777619u;
+	for (int i = 0; i < second->size; i++)
+	{
+		hash = (hash ^ (unsigned int)second->digits[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+bool ResultCache::Matches(CacheEntry* entry, unsigned int hash, int operation, const BigInt* first, const BigInt* second)
+{
+	return entry->hash == hash
+		&& entry->operation == operation
+		&& entry->firstSize == first->size
+		&& entry->secondSize == second->size
+		&& memcmp(entry->operands, first->digits, first->size * sizeof(int)) == 0
+		&& memcmp(entry->operands + first->size, second->digits, second->size * sizeof(int)) == 0;
+}
+
+bool ResultCache::Find(unsigned int hash, int operation, const BigInt* first, const BigInt* second, bool* condition, BigInt** digit)
+{
+	for (CacheEntry* entry = _buckets[hash % bucketsCount]; entry != NULL; entry = entry->next)
+	{
+		if (Matches(entry, hash, operation, first, second))
+		{
+			*condition = entry->condition;
+			*digit = NULL;
+			if (entry->result != NULL)
+			{
+				*digit = new BigInt(0, entry->resultSize);
+				memcpy((*digit)->digits, entry->result, entry->resultSize * sizeof(int));
+				(*digit)->size = entry->resultSize;
+			}
+
+			MoveToFront(entry);
+			_hits++;
+			return true;
+		}
+	}
+
+	_misses++;
+	return false;
+}
+
+void ResultCache::Add(unsigned int hash, int operation, const BigInt* first, const BigInt* second, bool condition, const BigInt* digit)
+{
+	int resultSize = digit != NULL ? digit->size : 0;
+	size_t bytes = sizeof(CacheEntry) + (first->size + second->size + resultSize) * sizeof(int);
+	if (bytes > _maxBytes)
+	{
+		return;
+	}
+
+	while (_usedBytes + bytes > _maxBytes)
+	{
+		Evict();
+	}
+
+	CacheEntry* entry = (CacheEntry*) malloc(sizeof(CacheEntry));
+	int* limbs = (int*) malloc((first->size + second->size + resultSize) * sizeof(int));
+	if (entry == NULL || limbs == NULL)
+	{
+		free(entry);
+		free(limbs);
+		return;
+	}
+
+	entry->hash = hash;
+	entry->operation = operation;
+	entry->firstSize = first->size;
+	entry->secondSize = second->size;
+	entry->operands = limbs;
+	memcpy(limbs, first->digits, first->size * sizeof(int));
+	memcpy(limbs + first->size, second->digits, second->size * sizeof(int));
+	entry->condition = condition;
+	entry->resultSize = resultSize;
+	entry->result = NULL;
+	if (digit != NULL)
+	{
+		entry->result = limbs + first->size + second->size;
+		memcpy(entry->result, digit->digits, resultSize * sizeof(int));
+	}
+	entry->bytes = bytes;
+
+	CacheEntry** bucket = &_buckets[entry->hash % bucketsCount];
+	entry->next = *bucket;
+	*bucket = entry;
+
+	entry->newer = NULL;
+	entry->older = NULL;
+	MoveToFront(entry);
+	_usedBytes += bytes;
+}
+
+void ResultCache::Unlink(CacheEntry* entry)
+{
+	if (entry->newer != NULL)
+	{
+		entry->newer->older = entry->older;
+	}
+	else if (_newest == entry)
+	{
+		_newest = entry->older;
+	}
+
+	if (entry->older != NULL)
+	{
+		entry->older->newer = entry->newer;
+	}
+	else if (_oldest == entry)
+	{
+		_oldest = entry->newer;
+	}
+
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+void ResultCache::MoveToFront(CacheEntry* entry)
+{
+	Unlink(entry);
+
+	entry->older = _newest;
+	if (_newest != NULL)
+	{
+		_newest->newer = entry;
+	}
+	_newest = entry;
+
+	if (_oldest == NULL)
+	{
+		_oldest = entry;
+	}
+}
+
+void ResultCache::Evict()
+{
+	CacheEntry* entry = _oldest;
+	Unlink(entry);
+
+	CacheEntry** link = &_buckets[entry->hash % bucketsCount];
+	while (*link != entry)
+	{
+		link = &(*link)->next;
+	}
+	*link = entry->next;
+
+	_usedBytes -= entry->bytes;
+	free(entry->operands);
+	free(entry);
+}
+
+int ResultCache::GetHits()
+{
+	return _hits;
+}
+
+int ResultCache::GetMisses()
+{
+	return _misses;
+}
+
+size_t ResultCache::GetUsedBytes()
+{
+	return _usedBytes;
+}
@@ -0,0 +1,55 @@
+#ifndef H_RESULT_CACHE
+#define H_RESULT_CACHE
+
+#include "BigInt.h"
+
+struct CacheEntry
+{
+	unsigned int hash;
+	int operation;
+	int firstSize;
+	int secondSize;
+	int* operands;
+	bool condition;
+	int resultSize;
+	int* result;
+	size_t bytes;
+	CacheEntry* next;
+	CacheEntry* newer;
+	CacheEntry* older;
+};
+
+// Кэш результатов строк по (операция, "цифры" операндов) с ограничением памяти и вытеснением LRU.
+// Хэш операндов считается один раз и передается и в Find, и в Add после промаха.
+// Add не бросает исключений: если памяти под запись нет, результат просто не кэшируется.
+class ResultCache
+{
+public:
+	static const int bucketsCount = 4096;
+
+	ResultCache(size_t maxBytes);
+	~ResultCache();
+
+	static unsigned int Hash(int operation, const BigInt* first, const BigInt* second);
+	bool Find(unsigned int hash, int operation, const BigInt* first, const BigInt* second, bool* condition, BigInt** digit);
+	void Add(unsigned int hash, int operation, const BigInt* first, const BigInt* second, bool condition, const BigInt* digit);
+	int GetHits();
+	int GetMisses();
+	size_t GetUsedBytes();
+
+private:
+	bool Matches(CacheEntry* entry, unsigned int hash, int operation, const BigInt* first, const BigInt* second);
+	void MoveToFront(CacheEntry* entry);
+	void Unlink(CacheEntry* entry);
+	void Evict();
+
+	CacheEntry* _buckets[bucketsCount];
+	CacheEntry* _newest;
+	CacheEntry* _oldest;
+	size_t _maxBytes;
+	size_t _usedBytes;
+	int _hits;
+	int _misses;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "RowScanner.h"
+#include "Common.h"
+#include <string.h>
+
+RowScanner::RowScanner()
+{
+	_inputFile = NULL;
+	_buffer = NULL;
+	_position = 0;
+	_length = 0;
+	_text = NULL;
+	_textLength = 0;
+	_textCapacity = 0;
+	_bytesRead = 0;
+	_lineNumber = 0;
+}
+
+RowScanner::~RowScanner()
+{
+	free(_buffer);
+	free(_text);
+}
+
+void RowScanner::Reset(FILE* inputFile)
+{
+	if (_buffer == NULL)
+	{
+		_buffer = (char*) malloc(bufferLength);
+		if (_buffer == NULL)
+		{
+			throw AppException(ErrorMessages::MEMORY_ERROR);
+		}
+	}
+
+	_inputFile = inputFile;
+	_position = 0;
+	_length = 0;
+	_textLength = 0;
+	_bytesRead = 0;
+	_lineNumber = 0;
+}
+
+//Строка без перевода строки (и без '\r' перед ним) дописывается в текст пачки, но не больше maxLength символов
+bool RowScanner::ScanLine(int* offset, int* length, int maxLength)
+{
+	*offset = _textLength;
+	long long lineLength = 0;
+	char last = 0;
+	bool scanned = false;
+	bool found = false;
+	while (!found)
+	{
+		if (_position == _length)
+		{
+			_length = (int)fread(_buffer, 1, bufferLength, _inputFile);
+			_position = 0;
+			if (_length == 0)
+			{
+				break;
+			}
+		}
+
+		char* start = _buffer + _position;
+		int available = _length - _position;
+		char* end = (char*) memchr(start, '\n', available);
+		int count = end != NULL ? (int)(end - start) : available;
+		long long stored = _textLength - *offset;
+		if (stored < maxLength)
+		{
+			AppendText(start, Min(count, maxLength - (int)stored));
+		}
+
+		if (count > 0)
+		{
+			last = start[count - 1];
+		}
+		lineLength += count;
+
+		found = end != NULL;
+		_position += found ? count + 1 : count;
+		_bytesRead += found ? count + 1 : count;
+		scanned = true;
+	}
+
+	if (scanned)
+	{
+		_lineNumber++;
+	}
+
+	if (lineLength > 0 && last == '\r')
+	{
+		lineLength--;
+		if (_textLength - *offset > lineLength)
+		{
+			_textLength--;
+		}
+	}
+	*length = lineLength < 0x7FFFFFFF ? (int)lineLength : 0x7FFFFFFF;
+
+	return scanned;
+}
+
+void RowScanner::ClearText()
+{
+	_textLength = 0;
+}
+
+const char* RowScanner::GetText()
+{
+	return _text;
+}
+
+long long RowScanner::GetBytesRead()
+{
+	return _bytesRead;
+}
+
+long long RowScanner::GetLineNumber()
+{
+	return _lineNumber;
+}
+
+void RowScanner::AppendText(const char* text, int length)
+{
+	if (_textLength + length > _textCapacity)
+	{
+		int capacity = Max(_textCapacity * 2, Max(_textLength + length, bufferLength));
+		char* resized = (char*) realloc(_text, capacity);
+		if (resized == NULL)
+		{
+			throw AppException(ErrorMessages::MEMORY_ERROR);
+		}
+
+		_text = resized;
+		_textCapacity = capacity;
+	}
+
+	memcpy(_text + _textLength, text, length);
+	_textLength += length;
+}
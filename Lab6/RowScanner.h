@@ -0,0 +1,38 @@
+#ifndef H_ROW_SCANNER
+#define H_ROW_SCANNER
+
+#include <stdio.h>
+
+// Находит границы строк задания поиском перевода строки (memchr) по буферу чтения.
+// Строки копируются в общий текст пачки без разбора: в "цифры" их переводят уже при выполнении.
+// От слишком длинной строки сохраняется только начало, но длина сообщается полная.
+class RowScanner
+{
+public:
+	static const int bufferLength = 65536;
+
+	RowScanner();
+	~RowScanner();
+
+	void Reset(FILE* inputFile);
+	bool ScanLine(int* offset, int* length, int maxLength);
+	void ClearText();
+	const char* GetText();
+	long long GetBytesRead();
+	long long GetLineNumber();
+
+private:
+	void AppendText(const char* text, int length);
+
+	FILE* _inputFile;
+	char* _buffer;
+	int _position;
+	int _length;
+	char* _text;
+	int _textLength;
+	int _textCapacity;
+	long long _bytesRead;
+	long long _lineNumber;
+};
+
+#endif
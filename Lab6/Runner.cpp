@@ -0,0 +1,356 @@
+#include "FileOperations.h"
+#include "AsyncIo.h"
+#include "Shards.h"
+#include "LimbMemory.h"
+#include <string.h>
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: lab6-run [options] [file]\n"
+		"  -i, --input <file>        input file (default: stdin)\n"
+		"  -o, --output <file>       output file (default: stdout)\n"
+		"  -e, --errors <file>       error records with line numbers (default: stderr)\n"
+		"  -f, --format <format>     output: decimal (default), hex or binary\n"
+		"  -t, --threads <n>         worker threads for rows\n"
+		"  -p, --processes <n>       split a text job file into row-aligned ranges run by n worker processes\n"
+		"  --numa                    pin worker processes to NUMA nodes in turn\n"
+		"  --pin-threads <mode>      pin worker threads: cpus (one CPU each) or numa (nodes in turn)\n"
+		"  --huge-pages <mode>       numbers in node-local huge pages: transparent or explicit (hugetlbfs)\n"
+		"  --batch <n>               rows read before executing them\n"
+		"  --row-batches             evaluate short +, -, * and comparison rows together in SIMD lanes\n"
+		"  --input-buffer <bytes>    input stream buffer size\n"
+		"  --output-buffer <bytes>   output stream buffer size\n"
+		"  --async-io                read ahead and write behind in background blocks (io_uring or a thread)\n"
+		"  --cache <bytes>           result cache size (shared out between threads)\n"
+		"  --power-cache <bytes>     power cache size (shared out between threads)\n"
+		"  --expressions             input contains expressions instead of rows\n"
+		"  --convert <file>          write the text job as a binary job file and exit\n"
+		"  --stats                   print throughput and latency histograms to stderr\n"
+		"  --stats-json <file>       write the same statistics (and kernel counters) as JSON\n"
+		"  -h, --help                show this help\n");
+}
+
+static bool IsOption(const char* argument, const char* shortName, const char* longName)
+{
+	return (shortName != NULL && strcmp(argument, shortName) == 0) || strcmp(argument, longName) == 0;
+}
+
+//Двоичное задание читаем без преобразования переводов строк, текстовое - как раньше
+static FILE* OpenInput(const char* name)
+{
+	FILE* inputFile = fopen(name, "rb");
+	if (inputFile == NULL)
+	{
+		return NULL;
+	}
+
+	int ch = fgetc(inputFile);
+	if (ch == FileOperations::binaryJobMagic[0])
+	{
+		ungetc(ch, inputFile);
+		return inputFile;
+	}
+
+	return freopen(name, "r", inputFile);
+}
+
+// lab6-run [options] [file]: выполняет строки задания из файла или из стандартного ввода
+int main(int argc, char** argv)
+{
+	const char* inputName = NULL;
+	const char* outputName = NULL;
+	const char* errorsName = NULL;
+	int threadsCount = 1;
+	int processesCount = 1;
+	bool numa = false;
+	ThreadPinning pinning = PIN_NONE;
+	HugePages hugePages = HUGE_PAGES_NONE;
+	int batchSize = 0;
+	long inputBuffer = 0;
+	long outputBuffer = 0;
+	long cacheBytes = 0;
+	long powerCacheBytes = 0;
+	bool expressions = false;
+	bool rowBatches = false;
+	bool asyncIo = false;
+	OutputFormat outputFormat = OUTPUT_DECIMAL;
+	const char* convertName = NULL;
+	bool statistics = false;
+	const char* statisticsName = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (IsOption(argument, "-h", "--help"))
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if (IsOption(argument, NULL, "--expressions"))
+		{
+			expressions = true;
+		}
+		else if (IsOption(argument, NULL, "--row-batches"))
+		{
+			rowBatches = true;
+		}
+		else if (IsOption(argument, NULL, "--async-io"))
+		{
+			asyncIo = true;
+		}
+		else if (IsOption(argument, NULL, "--numa"))
+		{
+			numa = true;
+		}
+		else if (IsOption(argument, NULL, "--stats"))
+		{
+			statistics = true;
+		}
+		else if (IsOption(argument, "-e", "--errors") && hasValue)
+		{
+			errorsName = argv[++i];
+		}
+		else if (IsOption(argument, "-f", "--format") && hasValue)
+		{
+			const char* format = argv[++i];
+			if (strcmp(format, "hex") == 0)
+			{
+				outputFormat = OUTPUT_HEX;
+			}
+			else if (strcmp(format, "binary") == 0)
+			{
+				outputFormat = OUTPUT_BINARY;
+			}
+			else if (strcmp(format, "decimal") != 0)
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if (IsOption(argument, NULL, "--pin-threads") && hasValue)
+		{
+			const char* mode = argv[++i];
+			if (strcmp(mode, "cpus") == 0)
+			{
+				pinning = PIN_CPUS;
+			}
+			else if (strcmp(mode, "numa") == 0)
+			{
+				pinning = PIN_NUMA_NODES;
+			}
+			else
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if (IsOption(argument, NULL, "--huge-pages") && hasValue)
+		{
+			const char* mode = argv[++i];
+			if (strcmp(mode, "transparent") == 0)
+			{
+				hugePages = HUGE_PAGES_TRANSPARENT;
+			}
+			else if (strcmp(mode, "explicit") == 0)
+			{
+				hugePages = HUGE_PAGES_EXPLICIT;
+			}
+			else
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if (IsOption(argument, NULL, "--convert") && hasValue)
+		{
+			convertName = argv[++i];
+		}
+		else if (IsOption(argument, NULL, "--stats-json") && hasValue)
+		{
+			statisticsName = argv[++i];
+		}
+		else if (IsOption(argument, "-i", "--input") && hasValue)
+		{
+			inputName = argv[++i];
+		}
+		else if (IsOption(argument, "-o", "--output") && hasValue)
+		{
+			outputName = argv[++i];
+		}
+		else if (IsOption(argument, "-t", "--threads") && hasValue)
+		{
+			threadsCount = atoi(argv[++i]);
+		}
+		else if (IsOption(argument, "-p", "--processes") && hasValue)
+		{
+			processesCount = atoi(argv[++i]);
+		}
+		else if (IsOption(argument, NULL, "--batch") && hasValue)
+		{
+			batchSize = atoi(argv[++i]);
+		}
+		else if (IsOption(argument, NULL, "--input-buffer") && hasValue)
+		{
+			inputBuffer = atol(argv[++i]);
+		}
+		else if (IsOption(argument, NULL, "--output-buffer") && hasValue)
+		{
+			outputBuffer = atol(argv[++i]);
+		}
+		else if (IsOption(argument, NULL, "--cache") && hasValue)
+		{
+			cacheBytes = atol(argv[++i]);
+		}
+		else if (IsOption(argument, NULL, "--power-cache") && hasValue)
+		{
+			powerCacheBytes = atol(argv[++i]);
+		}
+		else if (argument[0] != '-' && inputName == NULL)
+		{
+			inputName = argument;
+		}
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	FILE* inputFile = inputName != NULL ? OpenInput(inputName) : stdin;
+	if (convertName != NULL)
+	{
+		FILE* binaryFile = fopen(convertName, "wb");
+		FileOperations converter;
+		converter.ConvertToBinary(inputFile, binaryFile);
+		if (binaryFile != NULL)
+		{
+			fclose(binaryFile);
+		}
+
+		if (inputFile != NULL && inputFile != stdin)
+		{
+			fclose(inputFile);
+		}
+
+		return inputFile != NULL && binaryFile != NULL ? 0 : 1;
+	}
+
+	FILE* outputFile = outputName != NULL ? fopen(outputName, outputFormat == OUTPUT_BINARY ? "wb" : "w") : stdout;
+	FILE* errorFile = errorsName != NULL ? fopen(errorsName, "w") : stderr;
+	if (outputFile == NULL || errorFile == NULL)
+	{
+		fprintf(stderr, "%s\n", ErrorMessages::FILE_OPEN_ERROR);
+		if (inputFile != NULL && inputFile != stdin)
+		{
+			fclose(inputFile);
+		}
+
+		if (outputFile != NULL && outputFile != stdout)
+		{
+			fclose(outputFile);
+		}
+
+		if (errorFile != NULL && errorFile != stderr)
+		{
+			fclose(errorFile);
+		}
+		return 1;
+	}
+
+	//Процессы читают файл через отображение в память, обертка потоков им не нужна
+	if (asyncIo && processesCount < 2)
+	{
+		inputFile = OpenAsyncInput(inputFile, ASYNC_IO_URING);
+		outputFile = OpenAsyncOutput(outputFile, ASYNC_IO_URING);
+	}
+
+	if (inputFile != NULL && inputBuffer > 0)
+	{
+		setvbuf(inputFile, NULL, _IOFBF, inputBuffer);
+	}
+
+	if (outputBuffer > 0)
+	{
+		setvbuf(outputFile, NULL, _IOFBF, outputBuffer);
+	}
+
+	FileOperations operations;
+	operations.SetOutputFile(outputFile);
+	operations.SetOutputFormat(outputFormat);
+	operations.SetErrorFile(errorFile);
+	operations.SetThreadsCount(threadsCount);
+	operations.SetThreadPinning(pinning);
+	SetHugePages(hugePages);
+	if (rowBatches)
+	{
+		operations.EnableRowBatches();
+	}
+
+	if (batchSize > 0)
+	{
+		operations.SetBatchSize(batchSize);
+	}
+
+	if (cacheBytes > 0)
+	{
+		operations.EnableCache(cacheBytes);
+	}
+
+	if (powerCacheBytes > 0)
+	{
+		operations.EnablePowerCache(powerCacheBytes);
+	}
+
+	if (statistics || statisticsName != NULL)
+	{
+		operations.EnableStatistics();
+	}
+
+	ShardsResult sharded = SHARDS_UNSUPPORTED;
+	if (expressions)
+	{
+		operations.ReadExpressionsFromFile(inputFile);
+	}
+	else
+	{
+		sharded = ExecuteShards(&operations, inputFile, outputFile, errorFile, processesCount, numa);
+		if (sharded == SHARDS_UNSUPPORTED)
+		{
+			operations.ReadFromFile(inputFile);
+		}
+	}
+
+	if (statistics)
+	{
+		operations.GetStatistics()->Print(stderr);
+	}
+
+	if (statisticsName != NULL)
+	{
+		FILE* statisticsFile = fopen(statisticsName, "w");
+		if (statisticsFile != NULL)
+		{
+			operations.GetStatistics()->PrintJson(statisticsFile);
+			fclose(statisticsFile);
+		}
+	}
+
+	if (inputFile != NULL && inputFile != stdin)
+	{
+		fclose(inputFile);
+	}
+
+	if (outputFile != stdout)
+	{
+		fclose(outputFile);
+	}
+
+	if (errorFile != stderr)
+	{
+		fclose(errorFile);
+	}
+
+	return inputFile != NULL && sharded != SHARDS_FAILED ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+#include "Shards.h"
+#include "Numa.h"
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+
+struct Shard
+{
+	long long start;
+	long long length;
+	long long lineOffset;
+	FILE* output;
+	FILE* errors;
+	pid_t process;
+};
+
+//Итоги процесса куска в общей с родителем памяти: счетчики кэшей печатает один родитель
+struct ShardReport
+{
+	Statistics statistics;
+	CacheCounters cacheCounters;
+};
+
+static long long CountLines(const char* text, long long length)
+{
+	long long count = 0;
+	const char* end = text + length;
+	const char* line = (const char*) memchr(text, '\n', length);
+	while (line != NULL)
+	{
+		count++;
+		line = (const char*) memchr(line + 1, '\n', end - line - 1);
+	}
+
+	return count;
+}
+
+//Процесс куска выходит через _exit: буферы и деструкторы родителя остаются родителю.
+//Незаписанный вывод - такой же сбой куска, как и падение процесса
+static void ExecuteShard(FileOperations* operations, const char* text, Shard* shard, int node, ShardReport* report)
+{
+	if (node >= 0)
+	{
+		PinToNumaNode(node);
+	}
+
+	FILE* inputFile = fmemopen((void*)(text + shard->start), shard->length, "r");
+	operations->SetOutputFile(shard->output);
+	operations->SetErrorFile(shard->errors);
+	operations->SetLineOffset(shard->lineOffset);
+	operations->SetCacheCountersPrinting(false);
+	operations->ReadTextFromFile(inputFile);
+	if (inputFile != NULL)
+	{
+		fclose(inputFile);
+	}
+
+	if (operations->GetStatistics() != NULL)
+	{
+		memcpy(&report->statistics, operations->GetStatistics(), sizeof(Statistics));
+	}
+	operations->AddCacheCounters(&report->cacheCounters);
+
+	fflush(shard->output);
+	fflush(shard->errors);
+	_exit(inputFile != NULL && !ferror(shard->output) && !ferror(shard->errors) ? 0 : 1);
+}
+
+static void AppendFile(FILE* from, FILE* to)
+{
+	char buffer[65536];
+	rewind(from);
+	size_t read = 0;
+	while ((read = fread(buffer, 1, sizeof(buffer), from)) > 0)
+	{
+		if (to != NULL)
+		{
+			fwrite(buffer, 1, read, to);
+		}
+	}
+}
+
+//Куски - равные доли байт, сдвинутые вперед до границы строк задания; пустых кусков не бывает
+static int SplitShards(const char* text, long long length, int processesCount, Shard* shards)
+{
+	int shardsCount = 0;
+	long long start = 0;
+	long long lines = 0;
+	for (int i = 0; i < processesCount && start < length; i++)
+	{
+		long long target = length * (i + 1) / processesCount;
+		if (target <= start)
+		{
+			continue;
+		}
+
+		long long end = i == processesCount - 1 ? length : FileOperations::FindRowBoundary(text, length, target);
+		Shard* shard = shards + shardsCount;
+		shard->start = start;
+		shard->length = end - start;
+		shard->lineOffset = lines;
+		shard->output = tmpfile();
+		shard->errors = tmpfile();
+		shard->process = -1;
+		shardsCount++;
+		if (shard->output == NULL || shard->errors == NULL)
+		{
+			return -shardsCount;
+		}
+
+		lines += CountLines(text + start, end - start);
+		start = end;
+	}
+
+	return shardsCount;
+}
+
+static void CloseShards(Shard* shards, int shardsCount)
+{
+	for (int i = 0; i < shardsCount; i++)
+	{
+		if (shards[i].output != NULL)
+		{
+			fclose(shards[i].output);
+		}
+
+		if (shards[i].errors != NULL)
+		{
+			fclose(shards[i].errors);
+		}
+	}
+	delete[] shards;
+}
+
+ShardsResult ExecuteShards(FileOperations* operations, FILE* inputFile, FILE* outputFile, FILE* errorFile,
+	int processesCount, bool pinToNumaNodes)
+{
+	struct stat status;
+	int descriptor = inputFile != NULL ? fileno(inputFile) : -1;
+	if (processesCount < 2 || descriptor < 0 || fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0)
+	{
+		return SHARDS_UNSUPPORTED;
+	}
+
+	long long length = status.st_size;
+	const char* text = (const char*) mmap(NULL, length, PROT_READ, MAP_SHARED, descriptor, 0);
+	if (text == MAP_FAILED)
+	{
+		return SHARDS_UNSUPPORTED;
+	}
+
+	Shard* shards = new Shard[processesCount];
+	int shardsCount = text[0] != FileOperations::binaryJobMagic[0] ? SplitShards(text, length, processesCount, shards) : 0;
+	if (shardsCount <= 0)
+	{
+		CloseShards(shards, -shardsCount);
+		munmap((void*)text, length);
+		return SHARDS_UNSUPPORTED;
+	}
+
+	long long started = GetNanoseconds();
+	//Анонимная память приходит обнуленной: счетчики процессов копятся с нуля
+	void* memory = mmap(NULL, sizeof(ShardReport) * shardsCount, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		CloseShards(shards, shardsCount);
+		munmap((void*)text, length);
+		return SHARDS_UNSUPPORTED;
+	}
+	ShardReport* reports = (ShardReport*) memory;
+
+	//Несброшенный буфер родителя иначе напечатал бы каждый процесс
+	fflush(NULL);
+	int nodesCount = GetNumaNodesCount();
+	for (int i = 0; i < shardsCount; i++)
+	{
+		shards[i].process = fork();
+		if (shards[i].process == 0)
+		{
+			ExecuteShard(operations, text, shards + i, pinToNumaNodes ? i % nodesCount : -1, reports + i);
+		}
+
+		//Без процесса кусок выпал бы из вывода: запущенные процессы пишут только во временные файлы,
+		//поэтому их можно остановить и выполнить задание целиком здесь
+		if (shards[i].process < 0)
+		{
+			for (int j = 0; j < i; j++)
+			{
+				kill(shards[j].process, SIGKILL);
+				waitpid(shards[j].process, NULL, 0);
+			}
+
+			munmap(reports, sizeof(ShardReport) * shardsCount);
+			CloseShards(shards, shardsCount);
+			munmap((void*)text, length);
+			return SHARDS_UNSUPPORTED;
+		}
+	}
+
+	//Куски дописываются по порядку, пока следующие еще считаются. Вывод упавшего куска неполон,
+	//а следующие за ним сдвинули бы строки: с первого сбоя дописывать нечего, процессы только дожидаются
+	bool failed = false;
+	CacheCounters cacheCounters;
+	memset(&cacheCounters, 0, sizeof(cacheCounters));
+	for (int i = 0; i < shardsCount; i++)
+	{
+		int processStatus = 0;
+		bool shardFailed = waitpid(shards[i].process, &processStatus, 0) < 0
+			|| !WIFEXITED(processStatus) || WEXITSTATUS(processStatus) != 0;
+		if (shardFailed && errorFile != NULL)
+		{
+			fprintf(errorFile, "Shard %d: %s\n", i + 1, ErrorMessages::ERROR);
+		}
+
+		failed = failed || shardFailed;
+		if (failed)
+		{
+			continue;
+		}
+
+		AppendFile(shards[i].output, outputFile);
+		AppendFile(shards[i].errors, errorFile);
+		if (operations->GetStatistics() != NULL)
+		{
+			operations->GetStatistics()->Merge(&reports[i].statistics);
+		}
+
+		CacheCounters* counters = &reports[i].cacheCounters;
+		cacheCounters.hits += counters->hits;
+		cacheCounters.misses += counters->misses;
+		cacheCounters.usedBytes += counters->usedBytes;
+		cacheCounters.powerHits += counters->powerHits;
+		cacheCounters.powerReuses += counters->powerReuses;
+		cacheCounters.powerMisses += counters->powerMisses;
+		cacheCounters.powerUsedBytes += counters->powerUsedBytes;
+	}
+
+	if (operations->GetStatistics() != NULL)
+	{
+		operations->GetStatistics()->SetElapsed(GetNanoseconds() - started);
+	}
+	operations->PrintCacheCounters(&cacheCounters);
+	munmap(reports, sizeof(ShardReport) * shardsCount);
+
+	CloseShards(shards, shardsCount);
+	munmap((void*)text, length);
+	return failed ? SHARDS_FAILED : SHARDS_DONE;
+}
+
+#else
+
+ShardsResult ExecuteShards(FileOperations* operations, FILE* inputFile, FILE* outputFile, FILE* errorFile,
+	int processesCount, bool pinToNumaNodes)
+{
+	return SHARDS_UNSUPPORTED;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef H_SHARDS
+#define H_SHARDS
+
+#include "FileOperations.h"
+
+enum ShardsResult {SHARDS_UNSUPPORTED, SHARDS_DONE, SHARDS_FAILED};
+
+// Одно текстовое задание в нескольких процессах (Linux). Файл отображается в память и делится на
+// processesCount кусков по границам строк задания; каждый кусок выполняет свой процесс - копия operations
+// со всеми настройками (потоки, кэши, формат вывода), так что у процессов свои кучи и свои кэши.
+// Вывод и ошибки кусков пишутся во временные файлы и дописываются в outputFile и errorFile по порядку:
+// результат тот же, что у одного процесса. Статистика процессов складывается в статистику operations,
+// счетчики кэшей процессов складываются и печатаются один раз, как у одного процесса.
+// SHARDS_FAILED - процесс куска упал или не смог записать вывод: в errorFile пишется "Shard N: Error",
+// вывод дописывается только до этого куска.
+// При pinToNumaNodes процессы закрепляются за узлами NUMA по кругу.
+// operations еще не должен выполнять строк: потоки его пула не переживают fork.
+// SHARDS_UNSUPPORTED - вход не обычный файл, двоичное задание, не Linux или процесс не запустился
+// (запущенные к тому времени останавливаются): выполнять как обычно.
+ShardsResult ExecuteShards(FileOperations* operations, FILE* inputFile, FILE* outputFile, FILE* errorFile,
+	int processesCount, bool pinToNumaNodes);
+
+#endif
@@ -0,0 +1,105 @@
+#include "SmallRowBatch.h"
+#include <string.h>
+
+//Циклы по строкам векторизует компилятор; GCC дополнительно собирает AVX2-копию ядер
+//и выбирает ее при запуске, если процессор ее поддерживает
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define LANES_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define LANES_KERNEL
+#endif
+
+LANES_KERNEL void AddSmallRows(SmallRowBatch* batch)
+{
+	int count = batch->count;
+	int carry[SmallRowBatch::lanesCount] = {0};
+	for (int i = 0; i < SmallRowBatch::limbsCount; i++)
+	{
+		const int* left = batch->left[i];
+		const int* right = batch->right[i];
+		int* result = batch->result[i];
+		for (int lane = 0; lane < count; lane++)
+		{
+			int sum = left[lane] + right[lane] + carry[lane];
+			carry[lane] = sum >= BigInt::base ? 1 : 0;
+			result[lane] = sum - carry[lane] * BigInt::base;
+		}
+	}
+
+	memcpy(batch->result[SmallRowBatch::limbsCount], carry, count * sizeof(int));
+}
+
+LANES_KERNEL void SubtractSmallRows(SmallRowBatch* batch)
+{
+	int count = batch->count;
+	int borrow[SmallRowBatch::lanesCount] = {0};
+	for (int i = 0; i < SmallRowBatch::limbsCount; i++)
+	{
+		const int* left = batch->left[i];
+		const int* right = batch->right[i];
+		int* result = batch->result[i];
+		for (int lane = 0; lane < count; lane++)
+		{
+			int subtraction = left[lane] - right[lane] - borrow[lane];
+			borrow[lane] = subtraction < 0 ? 1 : 0;
+			result[lane] = subtraction + borrow[lane] * BigInt::base;
+		}
+	}
+
+	memcpy(batch->result[SmallRowBatch::limbsCount], borrow, count * sizeof(int));
+}
+
+//Столбец набирает не больше limbsCount произведений "цифр" (< 8 * base^2 < 2^31),
+//поэтому все произведения копятся в 32-битных столбцах, а переносы расставляются одним проходом
+LANES_KERNEL void MultiplySmallRows(SmallRowBatch* batch)
+{
+	int count = batch->count;
+	for (int k = 0; k < 2 * SmallRowBatch::limbsCount; k++)
+	{
+		memset(batch->result[k], 0, count * sizeof(int));
+	}
+
+	for (int i = 0; i < SmallRowBatch::limbsCount; i++)
+	{
+		const int* left = batch->left[i];
+		for (int j = 0; j < SmallRowBatch::limbsCount; j++)
+		{
+			const int* right = batch->right[j];
+			int* column = batch->result[i + j];
+			for (int lane = 0; lane < count; lane++)
+			{
+				column[lane] += left[lane] * right[lane];
+			}
+		}
+	}
+
+	unsigned int carry[SmallRowBatch::lanesCount] = {0};
+	for (int k = 0; k < 2 * SmallRowBatch::limbsCount; k++)
+	{
+		int* column = batch->result[k];
+		for (int lane = 0; lane < count; lane++)
+		{
+			unsigned int value = (unsigned int)column[lane] + carry[lane];
+			carry[lane] = value / BigInt::base;
+			column[lane] = (int)(value - carry[lane] * BigInt::base);
+		}
+	}
+}
+
+//Знак берется по старшей различающейся "цифре"
+LANES_KERNEL void CompareSmallRows(SmallRowBatch* batch)
+{
+	int count = batch->count;
+	int* sign = batch->result[0];
+	memset(sign, 0, count * sizeof(int));
+	for (int i = SmallRowBatch::limbsCount - 1; i >= 0; i--)
+	{
+		const int* left = batch->left[i];
+		const int* right = batch->right[i];
+		for (int lane = 0; lane < count; lane++)
+		{
+			int difference = (left[lane] > right[lane]) - (left[lane] < right[lane]);
+			sign[lane] = sign[lane] != 0 ? sign[lane] : difference;
+		}
+	}
+}
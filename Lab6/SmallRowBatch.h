@@ -0,0 +1,28 @@
+#ifndef H_SMALL_ROW_BATCH
+#define H_SMALL_ROW_BATCH
+
+#include "BigInt.h"
+
+// Пачка коротких строк одной операции в виде структуры массивов: left[i][lane] - "цифра" i первого
+// операнда строки lane. Ядро делает одно и то же с "цифрой" i всех строк, так что циклы по строкам
+// без ветвлений векторизуются компилятором: восемь строк на регистр AVX2 вместо разбора каждой строки.
+struct SmallRowBatch
+{
+	static const int limbsCount = 8;
+	static const int maxDecDigitsCount = limbsCount * BigInt::baseDimentions;
+	static const int lanesCount = 256;
+
+	int count;
+	int left[limbsCount][lanesCount];
+	int right[limbsCount][lanesCount];
+	int result[2 * limbsCount][lanesCount];
+};
+
+// Результаты в result: сумма - limbsCount + 1 "цифра", разность - limbsCount "цифр" и заем в result[limbsCount],
+// произведение - 2 * limbsCount "цифр", сравнение - знак (-1, 0, 1) в result[0].
+void AddSmallRows(SmallRowBatch* batch);
+void SubtractSmallRows(SmallRowBatch* batch);
+void MultiplySmallRows(SmallRowBatch* batch);
+void CompareSmallRows(SmallRowBatch* batch);
+
+#endif
@@ -0,0 +1,265 @@
+#include "Statistics.h"
+#include "Instrumentation.h"
+#include "Common.h"
+#include <chrono>
+
+static const char* phaseNames[PHASES_COUNT] = { "parse", "compute", "print" };
+
+long long GetNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Управляющие символы и кавычки не пишем в вывод как есть, а пишем код: у каждой операции свое имя (ключ JSON)
+static const char* GetOperationName(int operation, char* name)
+{
+	if (operation > ' ' && operation < 127 && operation != '"' && operation != '\\')
+	{
+		name[0] = (char)operation;
+		name[1] = '\0';
+	}
+	else
+	{
+		sprintf(name, "op_%d", operation);
+	}
+
+	return name;
+}
+
+static int HighestBit(long long value)
+{
+	int bit = 0;
+	while (value > 1)
+	{
+		value >>= 1;
+		bit++;
+	}
+
+	return bit;
+}
+
+//Значения меньше 2^(subBucketBits+1) лежат в своих корзинах,
+//дальше каждая степень двойки делится на 2^subBucketBits равных корзин
+int Statistics::GetBucketIndex(long long nanoseconds)
+{
+	const int subBuckets = 1 << subBucketBits;
+	if (nanoseconds < subBuckets)
+	{
+		return nanoseconds > 0 ? (int)nanoseconds : 0;
+	}
+
+	int shift = HighestBit(nanoseconds) - subBucketBits;
+	int bucket = shift * subBuckets + (int)(nanoseconds >> shift);
+
+	return Min(bucket, bucketsCount - 1);
+}
+
+long long Statistics::GetBucketLowerBound(int bucket)
+{
+	const int subBuckets = 1 << subBucketBits;
+	if (bucket < 2 * subBuckets)
+	{
+		return bucket;
+	}
+
+	int shift = bucket / subBuckets - 1;
+	return (long long)(bucket % subBuckets + subBuckets) << shift;
+}
+
+Statistics::Statistics()
+{
+	_rows = 0;
+	_bytes = 0;
+	_elapsed = 0;
+	for (int i = 0; i < PHASES_COUNT; i++)
+	{
+		_phases[i] = 0;
+	}
+
+	for (int i = 0; i < operationsCount; i++)
+	{
+		_counts[i] = 0;
+		_totals[i] = 0;
+		_maximums[i] = 0;
+		for (int j = 0; j < bucketsCount; j++)
+		{
+			_histograms[i][j] = 0;
+		}
+	}
+}
+
+void Statistics::AddRow(int operation, long long nanoseconds)
+{
+	//Неизвестные коды операций считаем вместе под кодом 0
+	if (operation < 0 || operation >= operationsCount)
+	{
+		operation = 0;
+	}
+
+	_rows++;
+	_counts[operation]++;
+	_totals[operation] += nanoseconds;
+	if (nanoseconds > _maximums[operation])
+	{
+		_maximums[operation] = nanoseconds;
+	}
+	_histograms[operation][GetBucketIndex(nanoseconds)]++;
+}
+
+void Statistics::AddPhase(int phase, long long nanoseconds)
+{
+	_phases[phase] += nanoseconds;
+}
+
+//Счетчики другого прогона (части задания) прибавляются; общее время - самое долгое из двух
+void Statistics::Merge(const Statistics* other)
+{
+	_rows += other->_rows;
+	_bytes += other->_bytes;
+	_elapsed = _elapsed > other->_elapsed ? _elapsed : other->_elapsed;
+	for (int i = 0; i < PHASES_COUNT; i++)
+	{
+		_phases[i] += other->_phases[i];
+	}
+
+	for (int i = 0; i < operationsCount; i++)
+	{
+		_counts[i] += other->_counts[i];
+		_totals[i] += other->_totals[i];
+		if (other->_maximums[i] > _maximums[i])
+		{
+			_maximums[i] = other->_maximums[i];
+		}
+
+		for (int j = 0; j < bucketsCount; j++)
+		{
+			_histograms[i][j] += other->_histograms[i][j];
+		}
+	}
+}
+
+void Statistics::SetBytes(long long bytes)
+{
+	_bytes = bytes;
+}
+
+void Statistics::SetElapsed(long long nanoseconds)
+{
+	_elapsed = nanoseconds;
+}
+
+long long Statistics::GetRows()
+{
+	return _rows;
+}
+
+long long Statistics::GetCount(int operation)
+{
+	return _counts[operation];
+}
+
+long long Statistics::GetBucket(int operation, int bucket)
+{
+	return _histograms[operation][bucket];
+}
+
+long long Statistics::GetPhase(int phase)
+{
+	return _phases[phase];
+}
+
+//Верхняя граница корзины, в которую попадает заданная доля строк
+long long Statistics::GetPercentile(int operation, double fraction)
+{
+	long long target = (long long)(_counts[operation] * fraction);
+	long long seen = 0;
+	for (int i = 0; i < bucketsCount - 1; i++)
+	{
+		seen += _histograms[operation][i];
+		if (seen > target)
+		{
+			long long upperBound = GetBucketLowerBound(i + 1);
+			return upperBound < _maximums[operation] ? upperBound : _maximums[operation];
+		}
+	}
+
+	return _maximums[operation];
+}
+
+void Statistics::Print(FILE* file)
+{
+	double seconds = _elapsed / 1e9;
+	fprintf(file, "Rows: %lld, bytes: %lld, time: %.3f s", _rows, _bytes, seconds);
+	if (seconds > 0)
+	{
+		fprintf(file, ", rows/s: %.1f, MB/s: %.2f", _rows / seconds, _bytes / seconds / 1e6);
+	}
+	fprintf(file, "\n");
+	fprintf(file, "Parse: %.3f s, compute: %.3f s, print: %.3f s\n",
+		_phases[PHASE_PARSE] / 1e9, _phases[PHASE_COMPUTE] / 1e9, _phases[PHASE_PRINT] / 1e9);
+
+	for (int operation = 0; operation < operationsCount; operation++)
+	{
+		if (_counts[operation] == 0)
+		{
+			continue;
+		}
+
+		char name[16];
+		fprintf(file, "Operation '%s': rows %lld, mean %.1f us, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+			GetOperationName(operation, name), _counts[operation], _totals[operation] / 1e3 / _counts[operation],
+			GetPercentile(operation, 0.5) / 1e3, GetPercentile(operation, 0.99) / 1e3,
+			GetPercentile(operation, 0.999) / 1e3, _maximums[operation] / 1e3);
+
+		for (int i = 0; i < bucketsCount; i++)
+		{
+			if (_histograms[operation][i] != 0)
+			{
+				fprintf(file, "  [%lld ns, %lld ns): %lld\n", GetBucketLowerBound(i), GetBucketLowerBound(i + 1), _histograms[operation][i]);
+			}
+		}
+	}
+}
+
+void Statistics::PrintJson(FILE* file)
+{
+	fprintf(file, "{\n  \"rows\": %lld,\n  \"bytes\": %lld,\n  \"elapsed_ns\": %lld,\n  \"phases_ns\": {", _rows, _bytes, _elapsed);
+	for (int i = 0; i < PHASES_COUNT; i++)
+	{
+		fprintf(file, "%s\"%s\": %lld", i == 0 ? "" : ", ", phaseNames[i], _phases[i]);
+	}
+	fprintf(file, "},\n  \"operations\": {");
+
+	bool first = true;
+	for (int operation = 0; operation < operationsCount; operation++)
+	{
+		if (_counts[operation] == 0)
+		{
+			continue;
+		}
+
+		char name[16];
+		fprintf(file, "%s\n    \"%s\": {\"rows\": %lld, \"total_ns\": %lld, \"max_ns\": %lld, \"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld, \"buckets\": [",
+			first ? "" : ",", GetOperationName(operation, name), _counts[operation], _totals[operation], _maximums[operation],
+			GetPercentile(operation, 0.5), GetPercentile(operation, 0.99), GetPercentile(operation, 0.999));
+		first = false;
+
+		bool firstBucket = true;
+		for (int i = 0; i < bucketsCount; i++)
+		{
+			if (_histograms[operation][i] != 0)
+			{
+				fprintf(file, "%s[%lld, %lld]", firstBucket ? "" : ", ", GetBucketLowerBound(i), _histograms[operation][i]);
+				firstBucket = false;
+			}
+		}
+		fprintf(file, "]}");
+	}
+	fprintf(file, "\n  }");
+
+#ifdef LAB6_INSTRUMENTATION
+	fprintf(file, ",\n  \"kernels\": ");
+	PrintKernelCountersJson(file);
+#endif
+	fprintf(file, "\n}\n");
+}
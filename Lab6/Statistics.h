@@ -0,0 +1,54 @@
+#ifndef H_STATISTICS
+#define H_STATISTICS
+
+#include <stdio.h>
+
+long long GetNanoseconds();
+
+enum Phase
+{
+	PHASE_PARSE,
+	PHASE_COMPUTE,
+	PHASE_PRINT,
+	PHASES_COUNT
+};
+
+// Счетчики прогона: строки, байты, время по фазам и гистограммы задержек по операциям.
+// Корзины как в HDR-гистограмме: 8 линейных подкорзин на каждую степень двойки (ошибка не больше 12.5%).
+class Statistics
+{
+public:
+	static const int operationsCount = 128;
+	static const int subBucketBits = 3;
+	static const int bucketsCount = 320;
+
+	Statistics();
+
+	void AddRow(int operation, long long nanoseconds);
+	void AddPhase(int phase, long long nanoseconds);
+	void Merge(const Statistics* other);
+	void SetBytes(long long bytes);
+	void SetElapsed(long long nanoseconds);
+	long long GetRows();
+	long long GetCount(int operation);
+	long long GetBucket(int operation, int bucket);
+	long long GetPhase(int phase);
+	long long GetPercentile(int operation, double fraction);
+	void Print(FILE* file);
+	void PrintJson(FILE* file);
+
+	static int GetBucketIndex(long long nanoseconds);
+	static long long GetBucketLowerBound(int bucket);
+
+private:
+	long long _rows;
+	long long _bytes;
+	long long _elapsed;
+	long long _phases[PHASES_COUNT];
+	long long _counts[operationsCount];
+	long long _totals[operationsCount];
+	long long _maximums[operationsCount];
+	long long _histograms[operationsCount][bucketsCount];
+};
+
+#endif
@@ -33,6 +33,7 @@ public:
 		if (_elements != NULL)
 		{
 			free(_elements);
+			_elements = NULL;
 		}
 		_count = 0;
 		_capacity = 0;
@@ -105,6 +106,12 @@ public:
 		}
 	}
 
+	T RemoveLast()
+	{
+		_count--;
+		return _elements[_count];
+	}
+
 	T* GetElements() 
 	{
 		return _elements;
@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+#include "Numa.h"
+
+ThreadPool::ThreadPool(int threadsCount, ThreadPinning pinning)
+{
+	_threadsCount = threadsCount;
+	_pinning = pinning;
+	_task = NULL;
+	_context = NULL;
+	_count = 0;
+	_next = 0;
+	_active = 0;
+	_generation = 0;
+	_stopped = false;
+
+	_threads = new std::thread[threadsCount];
+	for (int i = 0; i < threadsCount; i++)
+	{
+		_threads[i] = std::thread(WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopped = true;
+	}
+	_started.notify_all();
+
+	for (int i = 0; i < _threadsCount; i++)
+	{
+		_threads[i].join();
+	}
+
+	delete[] _threads;
+}
+
+int ThreadPool::GetThreadsCount()
+{
+	return _threadsCount;
+}
+
+void ThreadPool::Run(int count, Task task, void* context)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_task = task;
+	_context = context;
+	_count = count;
+	_next = 0;
+	_active = _threadsCount;
+	_generation++;
+	_started.notify_all();
+
+	while (_active > 0)
+	{
+		_finished.wait(lock);
+	}
+}
+
+void ThreadPool::WorkerLoop(ThreadPool* pool, int worker)
+{
+	//Поток закрепляется до первой задачи: все, что он выделит, уже будет рядом с ним
+	if (pool->_pinning == PIN_CPUS)
+	{
+		PinToCpu(worker);
+	}
+	else if (pool->_pinning == PIN_NUMA_NODES)
+	{
+		PinToNumaNode(worker % GetNumaNodesCount());
+	}
+
+	int generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(pool->_mutex);
+			while (!pool->_stopped && pool->_generation == generation)
+			{
+				pool->_started.wait(lock);
+			}
+
+			if (pool->_stopped)
+			{
+				return;
+			}
+
+			generation = pool->_generation;
+		}
+
+		for (int index = pool->_next++; index < pool->_count; index = pool->_next++)
+		{
+			pool->_task(index, worker, pool->_context);
+		}
+
+		std::lock_guard<std::mutex> lock(pool->_mutex);
+		pool->_active--;
+		if (pool->_active == 0)
+		{
+			pool->_finished.notify_one();
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef H_THREAD_POOL
+#define H_THREAD_POOL
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Закрепление рабочих потоков: каждый за своим процессором или потоки по кругу за узлами NUMA.
+// Закрепленный поток не переезжает между ядрами и узлами, его данные остаются в его кэшах и его памяти.
+enum ThreadPinning {PIN_NONE, PIN_CPUS, PIN_NUMA_NODES};
+
+// Постоянные рабочие потоки: Run раздает индексы 0..count-1 и ждет, пока все задачи выполнятся.
+class ThreadPool
+{
+public:
+	typedef void (*Task)(int index, int worker, void* context);
+
+	ThreadPool(int threadsCount, ThreadPinning pinning);
+	~ThreadPool();
+
+	int GetThreadsCount();
+	void Run(int count, Task task, void* context);
+
+private:
+	static void WorkerLoop(ThreadPool* pool, int worker);
+
+	std::thread* _threads;
+	int _threadsCount;
+	ThreadPinning _pinning;
+	std::mutex _mutex;
+	std::condition_variable _started;
+	std::condition_variable _finished;
+	Task _task;
+	void* _context;
+	int _count;
+	std::atomic<int> _next;
+	int _active;
+	int _generation;
+	bool _stopped;
+};
+
+#endif
@@ -4,10 +4,12 @@
 int main(int argc, char** argv)
 {
 	testing::InitGoogleTest(&argc, argv);
-	RUN_ALL_TESTS();
+	int result = RUN_ALL_TESTS();
+#ifdef _MSC_VER
 	std::getchar(); // keep console window open until Return keystroke
+#endif
 
 	//Worker worker;
 	//worker.Execute();
+	return result;
 }
-
@@ -0,0 +1,58 @@
+# cmake -DOUTPUT=<file> -DROWS=<count> -P GeneratePgoWorkload.cmake
+# Пишет задание в формате Tests/in: операнд, операнд, операция. Длины операндов
+# растут по строкам, чтобы профиль покрывал и короткие, и длинные числа.
+
+if(NOT OUTPUT)
+	message(FATAL_ERROR "OUTPUT is not set")
+endif()
+if(NOT ROWS)
+	set(ROWS 3000)
+endif()
+
+set(DIGITS "0123456789")
+set(NONZERO "123456789")
+set(OPERATIONS "+" "-" "*" "/" "^" "<" ">" "=")
+string(RANDOM LENGTH 8 ALPHABET ${NONZERO} RANDOM_SEED 6 SEED)
+
+function(random_number length result)
+	string(RANDOM LENGTH 1 ALPHABET ${NONZERO} head)
+	if(length GREATER 1)
+		math(EXPR tail_length "${length} - 1")
+		string(RANDOM LENGTH ${tail_length} ALPHABET ${DIGITS} tail)
+		set(head "${head}${tail}")
+	endif()
+	set(${result} "${head}" PARENT_SCOPE)
+endfunction()
+
+file(WRITE ${OUTPUT} "")
+set(content "")
+math(EXPR last "${ROWS} - 1")
+foreach(row RANGE ${last})
+	math(EXPR kind "${row} % 8")
+	list(GET OPERATIONS ${kind} operation)
+	# 1 .. ~4000 цифр
+	math(EXPR length "1 + (${row} * 37) % 4000")
+	if(operation STREQUAL "^")
+		math(EXPR base_length "1 + ${row} % 40")
+		random_number(${base_length} first)
+		string(RANDOM LENGTH 2 ALPHABET ${DIGITS} second)
+	elseif(operation STREQUAL "-" OR operation STREQUAL "/")
+		random_number(${length} first)
+		math(EXPR second_length "1 + ${length} / 2")
+		random_number(${second_length} second)
+	elseif(operation STREQUAL "=")
+		random_number(${length} first)
+		set(second "${first}")
+	else()
+		random_number(${length} first)
+		random_number(${length} second)
+	endif()
+	string(APPEND content "${first}\n${second}\n${operation}\n")
+
+	math(EXPR flush "${row} % 100")
+	if(flush EQUAL 99)
+		file(APPEND ${OUTPUT} "${content}")
+		set(content "")
+	endif()
+endforeach()
+file(APPEND ${OUTPUT} "${content}")